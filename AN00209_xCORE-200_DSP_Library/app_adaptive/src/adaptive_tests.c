@@ -0,0 +1,533 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+// XMOS DSP Library - Adaptive Filtering Functions Test Program, self-checking tests
+// Written in C because several of the filter objects hold pointers to their arrays
+
+// Include files
+#include <stdio.h>
+#include <math.h>
+#include <dsp.h>
+
+#define MAX_TAPS       64
+#define NUM_SAMPLES    1000
+#define SYSTEM_TAPS    64
+#define BLOCK_LENGTH   16
+#define NUM_BLOCKS     400
+
+// Arrays passed to the filters are global to keep them 64-bit aligned
+int32_t test_coeffs[MAX_TAPS];
+int32_t test_coeffs2[MAX_TAPS];
+int32_t test_state[MAX_TAPS];
+int32_t test_state2[MAX_TAPS];
+int32_t unknown[SYSTEM_TAPS];
+int32_t inputs[BLOCK_LENGTH * NUM_BLOCKS];
+int32_t references[BLOCK_LENGTH * NUM_BLOCKS];
+int32_t outputs[BLOCK_LENGTH];
+int32_t errors[BLOCK_LENGTH];
+
+// Uniform pseudo-random sample of 32 - shift bits, the same on every target
+static int32_t random_sample( uint32_t* seed, int32_t shift )
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (int32_t) *seed >> shift;
+}
+
+static void print_mismatches( const char* name, int32_t mismatches )
+{
+    printf( "%s: %d mismatches\n", name, mismatches );
+}
+
+static void report( const char* name, int32_t pass )
+{
+    printf( "%s: %s\n", name, pass ? "PASS" : "FAIL" );
+}
+
+// The references are the inputs filtered by the Q28 echo path in unknown[]
+static void make_references( void )
+{
+    for( int32_t n = 0; n < BLOCK_LENGTH * NUM_BLOCKS; ++n )
+    {
+        int64_t sum = 0;
+        for( int32_t i = 0; i < SYSTEM_TAPS && i <= n; ++i ) sum += (int64_t) unknown[i] * inputs[n - i];
+        references[n] = (int32_t)(sum >> 28);
+    }
+}
+
+// A decaying Q28 echo path of up to SYSTEM_TAPS taps driven by noise, white
+// or coloured by a one-pole low-pass with the Q30 pole; the references are
+// the echo of the inputs, so a converged filter of num_taps taps cancels them.
+static void make_echo( uint32_t* seed, int32_t num_taps, int32_t input_shift, int32_t pole )
+{
+    for( int32_t i = 0; i < SYSTEM_TAPS; ++i )
+        unknown[i] = i < num_taps ? random_sample( seed, 3 + i / 16 ) : 0;
+    for( int32_t n = 0; n < BLOCK_LENGTH * NUM_BLOCKS; ++n )
+    {
+        inputs[n] = random_sample( seed, input_shift );
+        if( n > 0 ) inputs[n] += ((int64_t) pole * inputs[n - 1]) >> 30;
+    }
+    make_references();
+}
+
+// Echo return loss enhancement in dB
+static double erle( double reference_energy, double error_energy )
+{
+    return 10 * log10( reference_energy / error_energy );
+}
+
+
+
+// The running energy must leave the output, error and coefficients
+// bit-exact with dsp_adaptive_nlms(), with and without periodic
+// recomputation of the energy. A single tap is not tested, as the energy of
+// one small sample can fall below the range dsp_adaptive_nlms() normalises.
+
+static void test_nlms_running( void )
+{
+    const int32_t sizes[] = { 2, 4, 5, 16, 33, 64 };
+    uint32_t seed = 1;
+    char name[64];
+
+    printf( "\nNLMS Running Energy\n" );
+    for( int32_t s = 0; s < 6; ++s )
+    {
+        int32_t N = sizes[s];
+        for( int32_t resync = 0; resync <= N; resync += N )
+        {
+            dsp_adaptive_nlms_energy_t tracker;
+            int32_t mismatches = 0;
+
+            for( int32_t i = 0; i < N; ++i ) test_coeffs[i] = test_coeffs2[i] = test_state[i] = test_state2[i] = 0;
+            dsp_adaptive_nlms_energy_init( &tracker, test_state2, N, resync );
+            for( int32_t n = 0; n < NUM_SAMPLES; ++n )
+            {
+                int32_t x = random_sample( &seed, 4 ), err, err2, y, y2;
+
+                y  = dsp_adaptive_nlms( x, x / 3, &err, test_coeffs, test_state, N, Q28(0.01), 28 );
+                y2 = dsp_adaptive_nlms_running( x, x / 3, &err2, test_coeffs2, test_state2, N,
+                                                Q28(0.01), 28, &tracker );
+                mismatches += y != y2 || err != err2;
+            }
+            for( int32_t i = 0; i < N; ++i ) mismatches += test_coeffs[i] != test_coeffs2[i];
+            sprintf( name, "dsp_adaptive_nlms_running N=%d resync=%d", N, resync );
+            print_mismatches( name, mismatches );
+        }
+    }
+}
+
+
+
+// Constrained and unconstrained PBFDAF identifying the echo path, and
+// rejection of unsupported sizes
+
+static void test_pbfdaf( void )
+{
+    static dsp_complex_t spectra[SYSTEM_TAPS];
+    static dsp_complex_t weights[SYSTEM_TAPS];
+    static dsp_complex_t scratch[3 * BLOCK_LENGTH];
+    static uint64_t      power[BLOCK_LENGTH + 1];
+    static int32_t       history[BLOCK_LENGTH];
+    dsp_adaptive_pbfdaf_t filter;
+    uint32_t seed = 1;
+    char name[64];
+
+    printf( "\nPBFDAF\n" );
+    make_echo( &seed, SYSTEM_TAPS, 8, 0 );
+    for( int32_t constrained = 0; constrained <= 1; ++constrained )
+    {
+        double reference_energy = 0, error_energy = 0;
+
+        dsp_adaptive_pbfdaf_init( &filter, BLOCK_LENGTH, SYSTEM_TAPS / BLOCK_LENGTH, spectra, weights,
+                                  scratch, power, history, Q24(0.5), 4, 1 << 14, constrained, 24 );
+        for( int32_t b = 0; b < NUM_BLOCKS; ++b )
+        {
+            int32_t offset = b * BLOCK_LENGTH;
+            dsp_adaptive_pbfdaf( &filter, inputs + offset, references + offset, outputs, errors );
+            if( 4 * b < 3 * NUM_BLOCKS ) continue;
+            for( int32_t i = 0; i < BLOCK_LENGTH; ++i )
+            {
+                reference_energy += (double) references[offset + i] * references[offset + i];
+                error_energy     += (double) errors[i] * errors[i];
+            }
+        }
+        // The unconstrained gradient converges to a biased solution
+        sprintf( name, "dsp_adaptive_pbfdaf constrained=%d ERLE above %d dB", constrained, constrained ? 60 : 30 );
+        report( name, erle( reference_energy, error_energy ) > (constrained ? 60 : 30) );
+    }
+
+    report( "dsp_adaptive_pbfdaf_init rejects block_length 24",
+            dsp_adaptive_pbfdaf_init( &filter, 24, 2, spectra, weights, scratch, power, history,
+                                      Q24(0.5), 4, 1 << 14, 1, 24 ) == -1 );
+    report( "dsp_adaptive_pbfdaf_init rejects num_partitions 0",
+            dsp_adaptive_pbfdaf_init( &filter, BLOCK_LENGTH, 0, spectra, weights, scratch, power, history,
+                                      Q24(0.5), 4, 1 << 14, 1, 24 ) == -1 );
+}
+
+
+
+// The fused LMS must follow dsp_adaptive_lms() bit-exactly: the outputs,
+// errors and state on every sample, and the coefficients once the deferred
+// update of the last sample has been applied by one more call. Odd sizes
+// exercise the single tap left over after the pairs.
+
+static void test_lms_fused( void )
+{
+    const int32_t sizes[] = { 1, 2, 3, 8, 9, 16, 31, 64 };
+    uint32_t seed = 1;
+    char name[64];
+
+    printf( "\nFused LMS\n" );
+    for( int32_t s = 0; s < 8; ++s )
+    {
+        int32_t N = sizes[s], mismatches = 0, err = 0, err2 = 0;
+
+        for( int32_t i = 0; i < N; ++i ) test_coeffs[i] = test_coeffs2[i] = test_state[i] = test_state2[i] = 0;
+        for( int32_t n = 0; n < NUM_SAMPLES; ++n )
+        {
+            int32_t x = random_sample( &seed, 4 ), d = x / 3 + test_state[N > 1] / 5, y, y2;
+
+            y  = dsp_adaptive_lms( x, d, &err, test_coeffs, test_state, N, Q28(0.01), 28 );
+            y2 = dsp_adaptive_lms_fused( x, d, &err2, test_coeffs2, test_state2, N, Q28(0.01), 28 );
+            mismatches += y != y2 || err != err2;
+            for( int32_t i = 0; i < N; ++i ) mismatches += test_state[i] != test_state2[i];
+        }
+        dsp_adaptive_lms_fused( 0, 0, &err2, test_coeffs2, test_state2, N, Q28(0.01), 28 );
+        for( int32_t i = 0; i < N; ++i ) mismatches += test_coeffs[i] != test_coeffs2[i];
+        sprintf( name, "dsp_adaptive_lms_fused N=%d", N );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+// RLS identifying a 16-tap echo path must converge within a few times N
+// samples, where NLMS on the same input is still far off. The
+// regularisation is well below the input power of about Q28(0.0003).
+
+static void test_rls( void )
+{
+    static int32_t sqrt_p[16 * 16];
+    static int64_t products[16];
+    static int32_t scratch[2 * 16];
+    dsp_adaptive_rls_t rls;
+    uint32_t seed = 2;
+    double reference_energy = 0, error_energy = 0, nlms_error_energy = 0;
+
+    printf( "\nRLS\n" );
+    make_echo( &seed, 16, 8, 0 );
+    for( int32_t i = 0; i < 16; ++i ) test_coeffs[i] = test_state[i] = test_coeffs2[i] = test_state2[i] = 0;
+    dsp_adaptive_rls_init( &rls, 16, sqrt_p, products, scratch, Q30(0.999), Q28(0.00001), 28 );
+    for( int32_t n = 0; n < 8 * 16; ++n )
+    {
+        int32_t err, err2;
+
+        dsp_adaptive_rls( inputs[n], references[n], &err, test_coeffs, test_state, &rls );
+        dsp_adaptive_nlms( inputs[n], references[n], &err2, test_coeffs2, test_state2, 16, Q28(0.5), 28 );
+        if( n < 4 * 16 ) continue;
+        reference_energy  += (double) references[n] * references[n];
+        error_energy      += (double) err * err;
+        nlms_error_energy += (double) err2 * err2;
+    }
+    report( "dsp_adaptive_rls ERLE over samples 4N to 8N above 50 dB",
+            erle( reference_energy, error_energy ) > 50 );
+    report( "dsp_adaptive_rls ahead of dsp_adaptive_nlms by 40 dB",
+            erle( reference_energy, error_energy ) > erle( reference_energy, nlms_error_energy ) + 40 );
+}
+
+
+
+// APA identifying a 32-tap echo path driven by strongly coloured noise. All
+// orders converge, but order 4 and above must be far ahead of order 1, which
+// is NLMS.
+
+static void test_apa( void )
+{
+    static int32_t history[32 + DSP_ADAPTIVE_APA_MAX_ORDER - 1];
+    const int32_t orders[] = { 1, 4, 8 };
+    dsp_adaptive_apa_t apa;
+    uint32_t seed = 3;
+    double erles[3];
+    char name[64];
+
+    printf( "\nAPA\n" );
+    make_echo( &seed, 32, 9, Q30(0.95) );
+    for( int32_t k = 0; k < 3; ++k )
+    {
+        double reference_energy = 0, error_energy = 0;
+
+        for( int32_t i = 0; i < 32; ++i ) test_coeffs[i] = 0;
+        dsp_adaptive_apa_init( &apa, 32, orders[k], history, Q28(0.5), Q28(0.0001), 28 );
+        for( int32_t n = 0; n < 2000; ++n )
+        {
+            int32_t err;
+
+            dsp_adaptive_apa( inputs[n], references[n], &err, test_coeffs, &apa );
+            if( n < 1000 ) continue;
+            reference_energy += (double) references[n] * references[n];
+            error_energy     += (double) err * err;
+        }
+        erles[k] = erle( reference_energy, error_energy );
+        sprintf( name, "dsp_adaptive_apa order=%d ERLE over samples 1000 to 2000 above %d dB",
+                 orders[k], k ? 100 : 15 );
+        report( name, erles[k] > (k ? 100 : 15) );
+    }
+    report( "dsp_adaptive_apa order=4 ahead of order=1 by 60 dB", erles[1] > erles[0] + 60 );
+}
+
+
+
+// Each channel of dsp_adaptive_nlms_multi() must produce the outputs and
+// errors of its own dsp_adaptive_nlms() bit-exactly, and the coefficients
+// once one more call has applied the deferred update.
+
+static void test_nlms_multi( void )
+{
+    static int32_t coeffs[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS][MAX_TAPS];
+    static int32_t states[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS][MAX_TAPS];
+    static int32_t multi_coeffs[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS * MAX_TAPS];
+    const int32_t sizes[] = { 2, 8, 34, 64 }, channels[] = { 1, 3, 8 };
+    uint32_t seed = 4;
+    char name[64];
+
+    printf( "\nMulti-channel NLMS\n" );
+    for( int32_t s = 0; s < 4; ++s )
+    {
+        for( int32_t c = 0; c < 3; ++c )
+        {
+            int32_t N = sizes[s], M = channels[c], mismatches = 0;
+            int32_t references[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+            int32_t outputs[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+            int32_t errors[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+            dsp_adaptive_nlms_energy_t tracker;
+
+            for( int32_t m = 0; m < M; ++m )
+            {
+                errors[m] = 0;
+                for( int32_t i = 0; i < N; ++i ) coeffs[m][i] = states[m][i] = multi_coeffs[m * N + i] = 0;
+            }
+            for( int32_t i = 0; i < N; ++i ) test_state[i] = 0;
+            dsp_adaptive_nlms_energy_init( &tracker, test_state, N, N );
+            for( int32_t n = 0; n < NUM_SAMPLES; ++n )
+            {
+                int32_t x = random_sample( &seed, 4 );
+
+                // A different echo of the input in each channel
+                for( int32_t m = 0; m < M; ++m ) references[m] = x / (m + 2) + test_state[m % N] / (m + 3);
+                dsp_adaptive_nlms_multi( x, references, errors, outputs, multi_coeffs, test_state,
+                                         N, M, Q28(0.05), 28, &tracker );
+                for( int32_t m = 0; m < M; ++m )
+                {
+                    int32_t err, y = dsp_adaptive_nlms( x, references[m], &err, coeffs[m], states[m],
+                                                        N, Q28(0.05), 28 );
+                    mismatches += y != outputs[m] || err != errors[m];
+                }
+            }
+            dsp_adaptive_nlms_multi( 0, references, errors, outputs, multi_coeffs, test_state,
+                                     N, M, Q28(0.05), 28, &tracker );
+            for( int32_t m = 0; m < M; ++m )
+            {
+                for( int32_t i = 0; i < N; ++i ) mismatches += coeffs[m][i] != multi_coeffs[m * N + i];
+            }
+            sprintf( name, "dsp_adaptive_nlms_multi N=%d M=%d", N, M );
+            print_mismatches( name, mismatches );
+        }
+    }
+}
+
+
+
+// Subband filter with 16 bands identifying a 64-tap echo path, driven by
+// white and by coloured noise. The attenuation is limited by the aliasing
+// between the bands, so it must reach 25 dB with a hop of 8 and 30 dB with a
+// hop of 4 over the last quarter of the run.
+
+static void test_subband( void )
+{
+    static int32_t       prototype[64];
+    static int32_t       histories[2][64];
+    static int32_t       overlaps[2][64];
+    static dsp_complex_t spectra[32 * 8];
+    static dsp_complex_t weights[32 * 8];
+    static dsp_complex_t scratch[3 * 8];
+    static uint64_t      power[8 + 1];
+    const int32_t hops[] = { 8, 4 }, poles[] = { 0, Q30(0.9) };
+    dsp_filterbank_t input_bank, reference_bank;
+    dsp_adaptive_subband_t filter;
+    uint32_t seed = 5;
+    char name[80];
+
+    printf( "\nSubband\n" );
+    for( int32_t c = 0; c < 2; ++c )
+    {
+        for( int32_t h = 0; h < 2; ++h )
+        {
+            // A tail of T samples needs T / hop + length / hop taps
+            int32_t hop = hops[h], taps = (SYSTEM_TAPS + 64) / hop, threshold = h ? 30 : 25;
+            double reference_energy = 0, error_energy = 0;
+
+            make_echo( &seed, SYSTEM_TAPS, 8, poles[c] );
+            dsp_design_filterbank_prototype( 16, hop, prototype, 64, 30 );
+            dsp_filterbank_init( &input_bank, prototype, 64, 16, hop, histories[0], overlaps[0], 30 );
+            dsp_filterbank_init( &reference_bank, prototype, 64, 16, hop, histories[1], overlaps[1], 30 );
+            dsp_adaptive_subband_init( &filter, &input_bank, &reference_bank, taps, spectra, weights,
+                                       scratch, power, Q24(0.5), 1 << 14, 24 );
+            for( int32_t n = 0; n < BLOCK_LENGTH * NUM_BLOCKS; n += hop )
+            {
+                dsp_adaptive_subband( &filter, inputs + n, references + n, errors );
+                if( 4 * n < 3 * BLOCK_LENGTH * NUM_BLOCKS ) continue;
+                for( int32_t i = 0; i < hop; ++i )
+                {
+                    reference_energy += (double) references[n + i] * references[n + i];
+                    error_energy     += (double) errors[i] * errors[i];
+                }
+            }
+            sprintf( name, "dsp_adaptive_subband %s input hop=%d ERLE above %d dB",
+                     c ? "coloured" : "white", hop, threshold );
+            report( name, erle( reference_energy, error_energy ) > threshold );
+        }
+    }
+}
+
+
+
+// IPNLMS on a sparse echo path converges faster than NLMS and behaves like
+// NLMS with alpha = -1. The inputs are the loudest for which the Q28 energy
+// of 64 taps does not saturate, so the weighted sum |b[k]| * x[n-k]^2 is
+// near its largest.
+
+static void test_ipnlms( void )
+{
+    const int32_t alphas[] = { Q30(-1), Q30(-0.5) };
+    uint32_t seed = 7;
+    double early[3], late[3];
+
+    printf( "\nIPNLMS\n" );
+    make_echo( &seed, 0, 4, 0 );
+    unknown[5]  = Q28(0.5);
+    unknown[20] = Q28(-0.3);
+    unknown[41] = Q28(0.2);
+    make_references();
+    for( int32_t f = 0; f < 3; ++f )
+    {
+        double reference_energy[2] = { 0, 0 }, error_energy[2] = { 0, 0 };
+
+        for( int32_t i = 0; i < SYSTEM_TAPS; ++i ) test_coeffs[i] = test_state[i] = 0;
+        for( int32_t n = 0; n < BLOCK_LENGTH * NUM_BLOCKS; ++n )
+        {
+            // ERLE over samples 3N to 4N, early in the convergence, and the last N
+            int32_t w = n < 3 * SYSTEM_TAPS ? -1 : n < 4 * SYSTEM_TAPS ? 0 :
+                        n < BLOCK_LENGTH * NUM_BLOCKS - SYSTEM_TAPS ? -1 : 1;
+            int32_t err;
+
+            if( f == 0 )
+                dsp_adaptive_nlms( inputs[n], references[n], &err, test_coeffs, test_state,
+                                   SYSTEM_TAPS, Q28(0.5), 28 );
+            else
+                dsp_adaptive_ipnlms( inputs[n], references[n], &err, test_coeffs, test_state,
+                                     SYSTEM_TAPS, Q28(0.5), alphas[f - 1], 28 );
+            if( w < 0 ) continue;
+            reference_energy[w] += (double) references[n] * references[n];
+            error_energy[w]     += (double) err * err;
+        }
+        early[f] = erle( reference_energy[0], error_energy[0] );
+        late[f]  = erle( reference_energy[1], error_energy[1] );
+    }
+    report( "dsp_adaptive_ipnlms alpha=-1 within 1 dB of dsp_adaptive_nlms",
+            fabs( early[1] - early[0] ) < 1 );
+    report( "dsp_adaptive_ipnlms alpha=-0.5 sparse path 6 dB ahead of dsp_adaptive_nlms",
+            early[2] > early[0] + 6 );
+    report( "dsp_adaptive_ipnlms converged ERLE above 100 dB", late[1] > 100 && late[2] > 100 );
+}
+
+
+
+// With one sample per frame the block filters are bit-exact with
+// dsp_adaptive_lms() and dsp_adaptive_nlms(). On frames of 16 samples they
+// identify the echo path with white and with coloured input.
+
+static void test_block( void )
+{
+    static int32_t state[SYSTEM_TAPS + BLOCK_LENGTH];
+    const int32_t sizes[] = { 2, 8, 33, 64 };
+    uint32_t seed = 9;
+    char name[80];
+
+    printf( "\nBlock LMS and NLMS\n" );
+    for( int32_t normalised = 0; normalised < 2; ++normalised )
+    {
+        for( int32_t s = 0; s < 4; ++s )
+        {
+            int32_t N = sizes[s], mismatches = 0;
+
+            for( int32_t i = 0; i < N; ++i ) test_coeffs[i] = test_coeffs2[i] = test_state[i] = 0;
+            for( int32_t i = 0; i <= N; ++i ) state[i] = 0;
+            for( int32_t n = 0; n < NUM_SAMPLES; ++n )
+            {
+                int32_t x = random_sample( &seed, 4 ), d = x / 3 + test_state[N / 2] / 5, y, err;
+
+                if( normalised )
+                {
+                    y = dsp_adaptive_nlms( x, d, &err, test_coeffs, test_state, N, Q28(0.5), 28 );
+                    dsp_adaptive_nlms_block( &x, &d, errors, outputs, test_coeffs2, state, N, 1,
+                                             Q28(0.5), 28 );
+                }
+                else
+                {
+                    y = dsp_adaptive_lms( x, d, &err, test_coeffs, test_state, N, Q28(0.01), 28 );
+                    dsp_adaptive_lms_block( &x, &d, errors, outputs, test_coeffs2, state, N, 1,
+                                            Q28(0.01), 28 );
+                }
+                mismatches += y != outputs[0] || err != errors[0];
+            }
+            for( int32_t i = 0; i < N; ++i ) mismatches += test_coeffs[i] != test_coeffs2[i];
+            sprintf( name, "dsp_adaptive_%slms_block L=1 N=%d", normalised ? "n" : "", N );
+            print_mismatches( name, mismatches );
+        }
+    }
+
+    // A 16-tap echo path identified on frames of 16 samples of white and of
+    // strongly coloured input, where consecutive states are nearly parallel
+    for( int32_t c = 0; c < 2; ++c )
+    {
+        make_echo( &seed, BLOCK_LENGTH, 6, c ? Q30(0.95) : 0 );
+        for( int32_t normalised = 0; normalised < 2; ++normalised )
+        {
+            double reference_energy = 0, error_energy = 0;
+            int32_t threshold;
+
+            for( int32_t i = 0; i < 2 * BLOCK_LENGTH; ++i ) test_coeffs[i] = state[i] = 0;
+            for( int32_t n = 0; n < BLOCK_LENGTH * NUM_BLOCKS; n += BLOCK_LENGTH )
+            {
+                if( normalised )
+                    dsp_adaptive_nlms_block( inputs + n, references + n, errors, outputs, test_coeffs,
+                                             state, BLOCK_LENGTH, BLOCK_LENGTH, Q28(1.0), 28 );
+                else
+                    dsp_adaptive_lms_block( inputs + n, references + n, errors, outputs, test_coeffs,
+                                            state, BLOCK_LENGTH, BLOCK_LENGTH, Q28(1.0), 28 );
+                if( 4 * n < 3 * BLOCK_LENGTH * NUM_BLOCKS ) continue;
+                for( int32_t i = 0; i < BLOCK_LENGTH; ++i )
+                {
+                    reference_energy += (double) references[n + i] * references[n + i];
+                    error_energy     += (double) errors[i] * errors[i];
+                }
+            }
+            threshold = normalised ? (c ? 15 : 100) : 10;
+            sprintf( name, "dsp_adaptive_%slms_block L=16 %s input ERLE above %d dB",
+                     normalised ? "n" : "", c ? "coloured" : "white", threshold );
+            report( name, erle( reference_energy, error_energy ) > threshold );
+        }
+    }
+}
+
+
+
+void adaptive_tests( void )
+{
+    test_nlms_running();
+    test_pbfdaf();
+    test_lms_fused();
+    test_rls();
+    test_apa();
+    test_nlms_multi();
+    test_subband();
+    test_ipnlms();
+    test_block();
+}
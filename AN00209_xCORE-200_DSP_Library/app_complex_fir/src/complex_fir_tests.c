@@ -0,0 +1,84 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+// XMOS DSP Library - Streaming Complex FIR Test Program, self-checking tests
+// Written in C because the filter object holds a pointer to its history
+
+// Include files
+#include <stdio.h>
+#include <dsp.h>
+
+#define MAX_TAPS       9
+#define NUM_SAMPLES    200
+
+// Arrays passed to the filters are global to keep them 64-bit aligned
+dsp_complex_t coeffs[MAX_TAPS];
+int32_t       real_coeffs[MAX_TAPS];
+dsp_complex_t states[4][2 * (MAX_TAPS + 1)];
+dsp_complex_t inputs[NUM_SAMPLES];
+dsp_complex_t outputs[2][8];
+
+// Uniform pseudo-random sample of 32 - shift bits, the same on every target
+static int32_t random_sample( uint32_t* seed, int32_t shift )
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (int32_t) *seed >> shift;
+}
+
+
+
+// The direct references accumulate in 64 bits and shift down without
+// rounding, as dsp_complex_fir() does; the inputs leave headroom for the
+// sum. Blocks of 1 to 7 samples exercise both the paired and the odd final
+// output of the block forms.
+
+void complex_fir_tests( void )
+{
+    dsp_complex_fir_t fir[4];
+    uint32_t seed = 1;
+
+    printf( "Streaming Complex FIR\n" );
+    for( uint32_t N = 1; N <= MAX_TAPS; ++N )
+    {
+        int32_t mismatches = 0, real_mismatches = 0;
+
+        for( uint32_t k = 0; k < N; ++k )
+        {
+            coeffs[k].re = random_sample( &seed, 1 );
+            coeffs[k].im = random_sample( &seed, 1 );
+            real_coeffs[k] = random_sample( &seed, 1 );
+        }
+        for( int32_t i = 0; i < NUM_SAMPLES; ++i )
+        {
+            inputs[i].re = random_sample( &seed, 5 );
+            inputs[i].im = random_sample( &seed, 5 );
+        }
+        for( int32_t f = 0; f < 4; ++f ) dsp_complex_fir_init( &fir[f], states[f], N );
+
+        for( int32_t pos = 0, length = 1; pos < NUM_SAMPLES; pos += length, length = length % 7 + 1 )
+        {
+            if( pos + length > NUM_SAMPLES ) length = NUM_SAMPLES - pos;
+            dsp_complex_fir_process_block( &fir[1], inputs + pos, outputs[0], length, coeffs, 31 );
+            dsp_complex_fir_process_real_block( &fir[3], inputs + pos, outputs[1], length, real_coeffs, 31 );
+            for( int32_t j = 0; j < length; ++j )
+            {
+                dsp_complex_t y  = dsp_complex_fir_process( &fir[0], inputs[pos + j], coeffs, 31 );
+                dsp_complex_t yr = dsp_complex_fir_process_real( &fir[2], inputs[pos + j], real_coeffs, 31 );
+                int64_t re = 0, im = 0, real_re = 0, real_im = 0;
+
+                for( int32_t k = 0; k < N && pos + j - k >= 0; ++k )
+                {
+                    dsp_complex_t x = inputs[pos + j - k];
+                    re += (int64_t) coeffs[k].re * x.re - (int64_t) coeffs[k].im * x.im;
+                    im += (int64_t) coeffs[k].re * x.im + (int64_t) coeffs[k].im * x.re;
+                    real_re += (int64_t) real_coeffs[k] * x.re;
+                    real_im += (int64_t) real_coeffs[k] * x.im;
+                }
+                mismatches += y.re != (int32_t)(re >> 31) || y.im != (int32_t)(im >> 31);
+                mismatches += outputs[0][j].re != y.re || outputs[0][j].im != y.im;
+                real_mismatches += yr.re != (int32_t)(real_re >> 31) || yr.im != (int32_t)(real_im >> 31);
+                real_mismatches += outputs[1][j].re != yr.re || outputs[1][j].im != yr.im;
+            }
+        }
+        printf( "dsp_complex_fir_process and _block N=%u: %d mismatches\n", N, mismatches );
+        printf( "dsp_complex_fir_process_real and _block N=%u: %d mismatches\n", N, real_mismatches );
+    }
+}
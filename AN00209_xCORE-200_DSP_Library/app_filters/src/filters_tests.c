@@ -0,0 +1,931 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+// XMOS DSP Library - Filtering Functions Test Program, self-checking tests
+// Written in C because the filter objects hold pointers to their arrays
+
+// Include files
+#include <stdio.h>
+#include <math.h>
+#include <dsp.h>
+
+#define TEST_SAMPLE_LENGTH    64
+
+// Uniform pseudo-random sample of 32 - shift bits, the same on every target
+static int32_t random_sample( uint32_t* seed, int32_t shift )
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (int32_t) *seed >> shift;
+}
+
+static void print_mismatches( const char* name, int32_t mismatches )
+{
+    printf( "%s: %d mismatches\n", name, mismatches );
+}
+
+static void report( const char* name, int32_t pass )
+{
+    printf( "%s: %s\n", name, pass ? "PASS" : "FAIL" );
+}
+
+// Stable biquad sections: random feed-forward terms, poles of radius 0.71
+static void random_biquads( int32_t coeffs[], int32_t num_sections, uint32_t* seed )
+{
+    for( int32_t i = 0; i < num_sections; ++i )
+    {
+        coeffs[5*i+0] = random_sample( seed, 4 );
+        coeffs[5*i+1] = random_sample( seed, 4 );
+        coeffs[5*i+2] = random_sample( seed, 4 );
+        coeffs[5*i+3] = Q28(1.2) + random_sample( seed, 12 );
+        coeffs[5*i+4] = Q28(-0.5);
+    }
+}
+
+// Arrays passed to the filters are global or static to keep them 64-bit
+// aligned for the double-word loads and stores
+int32_t test_input[TEST_SAMPLE_LENGTH];
+int32_t test_coeffs[256];
+int32_t test_state[256];
+int32_t test_state2[256];
+int32_t test_output[8 * TEST_SAMPLE_LENGTH];
+int16_t test_coeffs16[256] __attribute__((aligned(8)));
+int32_t test_output2[8 * TEST_SAMPLE_LENGTH];
+
+
+
+// One output of a FIR filter on the input history ending at input[n], with
+// one rounding as the double-word FIR loops do
+static int32_t fir_reference( const int32_t coeffs[], int32_t num_taps, const int32_t input[], int32_t n )
+{
+    int64_t sum = 1 << 30;
+    for( int32_t k = 0; k < num_taps && k <= n; ++k ) sum += (int64_t) coeffs[k] * input[n - k];
+    return (int32_t)(sum >> 31);
+}
+
+// Polyphase interpolation computed directly from the input history: output
+// i of input n is sub-filter i, phase_length taps long, applied to inputs n,
+// n-1, ...
+static void interpolate_reference( const int32_t input[], int32_t num_inputs, const int32_t coeffs[],
+                                   int32_t phase_length, int32_t L, int32_t output[] )
+{
+    for( int32_t n = 0; n < num_inputs; ++n )
+        for( int32_t i = 0; i < L; ++i )
+            output[n * L + i] = fir_reference( coeffs + i * phase_length, phase_length, input, n );
+}
+
+// Sub-filters of 2 and 6 taps (mod 8) exercise every tail of the unrolled
+// double-word loop
+
+static const int32_t phase_lengths[5] = { 2, 6, 8, 10, 14 };
+
+static void test_interpolate_block( void )
+{
+    uint32_t seed = 1;
+
+    printf( "\nBlock Interpolation\n" );
+    for( int32_t p = 0; p < 5; ++p )
+    {
+        for( int32_t r = 2; r <= 4; ++r )
+        {
+            int32_t taps = phase_lengths[p] * r, mismatches = 0;
+            char name[64];
+
+            for( int32_t i = 0; i < taps; ++i ) test_coeffs[i] = random_sample( &seed, 4 );
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 2 );
+            for( int32_t i = 0; i < taps; ++i ) test_state[i] = test_state2[i] = 0;
+
+            interpolate_reference( test_input, TEST_SAMPLE_LENGTH, test_coeffs, phase_lengths[p], r, test_output );
+            dsp_filters_interpolate_block( test_input, TEST_SAMPLE_LENGTH, test_coeffs, test_state2, taps, r, test_output2, 31 );
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH * r; ++i ) mismatches += test_output[i] != test_output2[i];
+
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+            {
+                dsp_filters_interpolate( test_input[i], test_coeffs, test_state, taps, r, test_output2, 31 );
+                for( int32_t j = 0; j < r; ++j ) mismatches += test_output[i * r + j] != test_output2[j];
+            }
+            sprintf( name, "dsp_filters_interpolate and _block taps=%d L=%d", taps, r );
+            print_mismatches( name, mismatches );
+        }
+    }
+}
+
+// Every M-th output of the interpolator by L is an output of the L/M resampler
+
+static void test_resampler( void )
+{
+    const int32_t ratios[3][2] = { { 3, 2 }, { 2, 3 }, { 4, 3 } };
+    dsp_filters_resampler_t resampler;
+    uint32_t seed = 2;
+
+    printf( "\nRational Resampler\n" );
+    for( int32_t p = 0; p < 5; ++p )
+    {
+        for( int32_t k = 0; k < 3; ++k )
+        {
+            int32_t L = ratios[k][0], M = ratios[k][1], taps = phase_lengths[p] * L;
+            int32_t count = 0, mismatches = 0;
+            char name[64];
+
+            for( int32_t i = 0; i < taps; ++i ) test_coeffs[i] = random_sample( &seed, 4 );
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 2 );
+
+            interpolate_reference( test_input, TEST_SAMPLE_LENGTH, test_coeffs, phase_lengths[p], L, test_output );
+            dsp_filters_resampler_init( &resampler, test_coeffs, test_state2, taps, L, M, 31 );
+
+            // Split the input into blocks of 5 samples to exercise the phase carried between calls
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; i += 5 )
+            {
+                int32_t n = (TEST_SAMPLE_LENGTH - i < 5) ? TEST_SAMPLE_LENGTH - i : 5;
+                count += dsp_filters_resampler_process( &resampler, test_input + i, n, test_output2 + count );
+            }
+
+            if( count != (TEST_SAMPLE_LENGTH * L + M - 1) / M ) ++mismatches;
+            for( int32_t i = 0; i < count; ++i ) mismatches += test_output2[i] != test_output[i * M];
+            sprintf( name, "dsp_filters_resampler_process taps=%d L=%d M=%d outputs=%d", taps, L, M, count );
+            print_mismatches( name, mismatches );
+        }
+    }
+}
+
+
+
+// With a ratio of 1/P every output falls on a sub-filter boundary (mu = 0),
+// so each phase of the ASRC equals a plain FIR of the matching sub-filter
+
+static void test_asrc( void )
+{
+    enum { phases = 4, max_taps = 10 * phases };
+    const int32_t one = 1 << DSP_FILTERS_ASRC_RATIO_Q;
+    static int32_t farrow[4 * max_taps];
+    dsp_filters_asrc_t asrc;
+    uint32_t seed = 3;
+
+    printf( "\nAsynchronous Sample Rate Converter\n" );
+    for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 2 );
+
+    // A ratio of 1/(2*phases) places every output on a phase boundary or half
+    // way between two, so the Horner evaluation of each output can be
+    // reproduced from sub-filter outputs with mu = 0 or 0.5
+    for( int32_t l = 0; l < 4; ++l )
+    {
+        int32_t length = phase_lengths[l], taps = length * phases;
+
+        for( int32_t i = 0; i < taps; ++i ) test_coeffs[i] = random_sample( &seed, 4 );
+        for( int32_t order = 1; order <= 3; order += 2 )
+        {
+            int32_t count, mismatches = 0;
+            char name[64];
+
+            dsp_filters_asrc_design( test_coeffs, taps, phases, order, farrow );
+            dsp_filters_asrc_init( &asrc, farrow, test_state, taps, phases, order, one / (2 * phases), 31 );
+            count = dsp_filters_asrc_process( &asrc, test_input, TEST_SAMPLE_LENGTH, test_output );
+
+            if( count != TEST_SAMPLE_LENGTH * 2 * phases ) ++mismatches;
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+                for( int32_t j = 0; j < 2 * phases; ++j )
+                {
+                    const int32_t* cc = farrow + (j >> 1) * (order + 1) * length;
+                    int32_t mu = (j & 1) << 30, y = fir_reference( cc + order * length, length, test_input, i );
+
+                    for( int32_t d = order - 1; d >= 0; --d )
+                        y = (int32_t)(((int64_t) y * mu + (1 << 30)) >> 31)
+                          + fir_reference( cc + d * length, length, test_input, i );
+                    mismatches += test_output[i * 2 * phases + j] != y;
+                }
+            sprintf( name, "dsp_filters_asrc_process taps=%d order=%d ratio=1/%d", taps, order, 2 * phases );
+            print_mismatches( name, mismatches );
+        }
+    }
+
+    // The number of outputs follows the ratio, and ratios outside (0, 4) are rejected
+    dsp_filters_asrc_init( &asrc, farrow, test_state, max_taps, phases, 3, one + one / 8, 31 );
+    printf( "dsp_filters_asrc_process ratio=1.125 outputs=%d\n",
+            dsp_filters_asrc_process( &asrc, test_input, TEST_SAMPLE_LENGTH, test_output ) );
+    printf( "dsp_filters_asrc_set_ratio ratio=0 returns %d\n", dsp_filters_asrc_set_ratio( &asrc, 0 ) );
+    printf( "dsp_filters_asrc_set_ratio ratio=4 returns %d\n", dsp_filters_asrc_set_ratio( &asrc, 4 * one ) );
+    printf( "dsp_filters_asrc_process ratio kept, outputs=%d\n",
+            dsp_filters_asrc_process( &asrc, test_input, TEST_SAMPLE_LENGTH, test_output ) );
+}
+
+
+
+static void test_biquads_multichannel( void )
+{
+    enum { channels = 3, sections = 4, frame = 16 };
+    static int32_t coeffs[channels * sections * 5], state[channels][sections * 4];
+    static int32_t frame_data[channels * frame], reference[channels * frame];
+    uint32_t seed = 4;
+
+    printf( "\nMulti-channel Cascaded BiQuads\n" );
+    random_biquads( coeffs, channels * sections, &seed );
+    for( int32_t mode = 0; mode < 4; ++mode )
+    {
+        int32_t interleaved = mode & 1, per_channel = mode >> 1, mismatches = 0;
+        char name[80];
+
+        for( int32_t i = 0; i < channels * sections * 4; ++i ) test_state[i] = 0;
+        for( int32_t c = 0; c < channels; ++c )
+            for( int32_t i = 0; i < sections * 4; ++i ) state[c][i] = 0;
+
+        for( int32_t f = 0; f < 4; ++f )
+        {
+            for( int32_t c = 0; c < channels; ++c )
+            {
+                const int32_t* cc = per_channel ? coeffs + c * sections * 5 : coeffs;
+                for( int32_t n = 0; n < frame; ++n )
+                {
+                    int32_t index = interleaved ? n * channels + c : c * frame + n;
+                    frame_data[index] = random_sample( &seed, 4 );
+                    reference[index] = dsp_filters_biquads( frame_data[index], cc, state[c], sections, 28 );
+                }
+            }
+            dsp_filters_biquads_multichannel( frame_data, channels, frame, interleaved,
+                                              coeffs, per_channel, test_state, sections, 28 );
+            for( int32_t i = 0; i < channels * frame; ++i ) mismatches += frame_data[i] != reference[i];
+        }
+        sprintf( name, "dsp_filters_biquads_multichannel interleaved=%d per_channel_coeffs=%d",
+                 interleaved, per_channel );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+// Frames alternate with per-sample calls on the same state, and the final
+// states must also match
+
+static void test_biquads_block( void )
+{
+    enum { max_sections = 6, frame = 13 };
+    static int32_t coeffs[max_sections * 5];
+    uint32_t seed = 5;
+
+    printf( "\nFrame-based Cascaded BiQuads\n" );
+    for( int32_t sections = 1; sections <= max_sections; ++sections )
+    {
+        int32_t mismatches = 0;
+        char name[64];
+
+        random_biquads( coeffs, sections, &seed );
+        for( int32_t i = 0; i < sections * 4; ++i ) test_state[i] = test_state2[i] = 0;
+        for( int32_t f = 0; f < 6; ++f )
+        {
+            for( int32_t i = 0; i < frame; ++i )
+            {
+                test_input[i] = random_sample( &seed, 4 );
+                test_output[i] = dsp_filters_biquads( test_input[i], coeffs, test_state, sections, 28 );
+            }
+            if( f & 1 )
+            {
+                // In place
+                for( int32_t i = 0; i < frame; ++i ) test_output2[i] = test_input[i];
+                dsp_filters_biquads_block( test_output2, test_output2, frame, coeffs, test_state2, sections, 28 );
+            }
+            else if( f & 2 )
+                dsp_filters_biquads_block( test_input, test_output2, frame, coeffs, test_state2, sections, 28 );
+            else
+                for( int32_t i = 0; i < frame; ++i )
+                    test_output2[i] = dsp_filters_biquads( test_input[i], coeffs, test_state2, sections, 28 );
+            for( int32_t i = 0; i < frame; ++i ) mismatches += test_output[i] != test_output2[i];
+        }
+        for( int32_t i = 0; i < sections * 4; ++i ) mismatches += test_state[i] != test_state2[i];
+        sprintf( name, "dsp_filters_biquads_block sections=%d", sections );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+// Error feedback keeps every discarded fraction, so for a pure gain the sum of
+// the outputs scaled back up plus the carried fraction equals the exact sum
+
+static void test_biquad_ef( void )
+{
+    static int32_t coeffs[10], state[3][12], plain_state[4];
+    double reference[4] = { 0, 0, 0, 0 }, error_plain = 0, error_ef = 0;
+    uint32_t seed = 6;
+
+    printf( "\nBiQuad with Error Feedback\n" );
+    for( int32_t q = 28; q <= 31; q += 3 )
+    {
+        int64_t exact = 0, total = 0;
+
+        coeffs[0] = 0x2AAAAAAB >> (31 - q);
+        coeffs[1] = coeffs[2] = coeffs[3] = coeffs[4] = 0;
+        for( int32_t i = 0; i < 6; ++i ) state[0][i] = 0;
+        for( int32_t n = 0; n < 1000; ++n )
+        {
+            int32_t x = random_sample( &seed, 8 );
+            exact += (int64_t) x * coeffs[0];
+            total += dsp_filters_biquad_ef( x, coeffs, state[0], q );
+        }
+        printf( "dsp_filters_biquad_ef q_format=%d gain residue: %s\n", q,
+                exact - (total << q) == state[0][4] ? "PASS" : "FAIL" );
+    }
+
+    // A 20 Hz low-pass at 96 kHz: error feedback must cut the output error
+    dsp_design_biquad_lowpass( 20.0 / 96000, 0.707, coeffs, 30 );
+    for( int32_t i = 0; i < 6; ++i ) state[0][i] = 0;
+    for( int32_t i = 0; i < 4; ++i ) plain_state[i] = 0;
+    for( int32_t n = 0; n < 20000; ++n )
+    {
+        int32_t x = random_sample( &seed, 2 );
+        double  y = ((double) x * coeffs[0] + reference[0] * coeffs[1] + reference[1] * coeffs[2]
+                  + reference[2] * coeffs[3] + reference[3] * coeffs[4]) / (1 << 30);
+        double  e1 = dsp_filters_biquad( x, coeffs, plain_state, 30 ) - y;
+        double  e2 = dsp_filters_biquad_ef( x, coeffs, state[0], 30 ) - y;
+
+        reference[1] = reference[0]; reference[0] = x;
+        reference[3] = reference[2]; reference[2] = y;
+        error_plain += e1 * e1; error_ef += e2 * e2;
+    }
+    printf( "dsp_filters_biquad_ef low-pass error below dsp_filters_biquad(): %s\n",
+            error_ef * 100 < error_plain ? "PASS" : "FAIL" );
+
+    // The cascade is the same as chaining the single sections
+    {
+        int32_t mismatches = 0;
+
+        dsp_design_biquad_lowpass( 30.0 / 96000, 0.707, coeffs, 30 );
+        dsp_design_biquad_highpass( 20.0 / 96000, 0.707, coeffs + 5, 30 );
+        for( int32_t i = 0; i < 12; ++i ) state[0][i] = state[1][i] = state[2][i] = 0;
+        for( int32_t n = 0; n < 1000; ++n )
+        {
+            int32_t x = random_sample( &seed, 2 );
+            int32_t y = dsp_filters_biquad_ef( x, coeffs, state[1], 30 );
+            y = dsp_filters_biquad_ef( y, coeffs + 5, state[2], 30 );
+            mismatches += y != dsp_filters_biquads_ef( x, coeffs, state[0], 2, 30 );
+        }
+        print_mismatches( "dsp_filters_biquads_ef sections=2", mismatches );
+    }
+}
+
+
+
+static void test_biquad_smooth( void )
+{
+    dsp_filters_biquad_smooth_t filter, filter2;
+    int32_t coeffs[5], target[5], monotonic = 1, steps = 0, mismatches = 0;
+    uint32_t seed = 7;
+
+    printf( "\nSmoothed BiQuad\n" );
+
+    // With the target equal to the coefficients it is a plain biquad
+    random_biquads( coeffs, 1, &seed );
+    dsp_filters_biquad_smooth_init( &filter, coeffs, 3, 28 );
+    for( int32_t i = 0; i < 4; ++i ) test_state[i] = 0;
+    for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 4 );
+    dsp_filters_biquad_smooth_process( &filter, test_input, test_output, TEST_SAMPLE_LENGTH, 8 );
+    dsp_filters_biquads_block( test_input, test_output2, TEST_SAMPLE_LENGTH, coeffs, test_state, 1, 28 );
+    for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) mismatches += test_output[i] != test_output2[i];
+    print_mismatches( "dsp_filters_biquad_smooth_process fixed target", mismatches );
+
+    // An update interval of 0 behaves as 1
+    random_biquads( target, 1, &seed );
+    dsp_filters_biquad_smooth_init( &filter, coeffs, 3, 28 );
+    dsp_filters_biquad_smooth_init( &filter2, coeffs, 3, 28 );
+    dsp_filters_biquad_smooth_set_target( &filter, target );
+    dsp_filters_biquad_smooth_set_target( &filter2, target );
+    dsp_filters_biquad_smooth_process( &filter, test_input, test_output, TEST_SAMPLE_LENGTH, 1 );
+    dsp_filters_biquad_smooth_process( &filter2, test_input, test_output2, TEST_SAMPLE_LENGTH, 0 );
+    mismatches = 0;
+    for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) mismatches += test_output[i] != test_output2[i];
+    print_mismatches( "dsp_filters_biquad_smooth_process update_interval=0", mismatches );
+
+    // A full-scale ramp from the most negative to the most positive value
+    // moves monotonically and lands exactly on the target
+    coeffs[0] = INT32_MIN; target[0] = INT32_MAX;
+    for( int32_t k = 1; k < 5; ++k ) coeffs[k] = target[k] = 0;
+    dsp_filters_biquad_smooth_init( &filter, coeffs, 2, 28 );
+    dsp_filters_biquad_smooth_set_target( &filter, target );
+    for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = 0;
+    while( filter.coeffs[0] != INT32_MAX && steps < 1000 )
+    {
+        int32_t previous = filter.coeffs[0];
+        dsp_filters_biquad_smooth_process( &filter, test_input, test_output, 1, 1 );
+        monotonic &= filter.coeffs[0] > previous;
+        ++steps;
+    }
+    printf( "dsp_filters_biquad_smooth_process full-scale ramp: %s\n",
+            monotonic && filter.coeffs[0] == INT32_MAX ? "PASS" : "FAIL" );
+}
+
+
+
+// The reference is N cascaded running sums of R samples, sampled every R
+// inputs and shifted by the smallest s with R^N <= 2^s
+
+static void test_cic( void )
+{
+    const int32_t configs[4][2] = { { 3, 4 }, { 5, 3 }, { 16, 1 }, { 64, 4 } };
+    static int64_t sums[DSP_FILTERS_CIC_MAX_ORDER + 1][TEST_SAMPLE_LENGTH * 4];
+    dsp_filters_cic_t cic;
+    uint32_t seed = 8;
+
+    printf( "\nCIC Decimator\n" );
+    for( int32_t k = 0; k < 4; ++k )
+    {
+        int32_t R = configs[k][0], N = configs[k][1], length = TEST_SAMPLE_LENGTH * 4;
+        int32_t count = 0, mismatches = 0, shift = 0;
+        int64_t gain = 1;
+        char name[64];
+
+        for( int32_t i = 0; i < N; ++i ) gain *= R;
+        while( ((int64_t) 1 << shift) < gain ) ++shift;
+
+        for( int32_t i = 0; i < length; ++i ) sums[0][i] = random_sample( &seed, 25 );
+        for( int32_t m = 1; m <= N; ++m )
+            for( int32_t i = 0; i < length; ++i )
+            {
+                sums[m][i] = 0;
+                for( int32_t j = 0; j < R && j <= i; ++j ) sums[m][i] += sums[m-1][i-j];
+            }
+
+        dsp_filters_cic_init( &cic, N, R );
+        for( int32_t i = 0; i < length; i += 37 )
+        {
+            int32_t n = length - i < 37 ? length - i : 37;
+            for( int32_t j = 0; j < n; ++j ) test_input[j] = (int32_t) sums[0][i + j];
+            count += dsp_filters_cic_decimate( &cic, test_input, n, test_output + count );
+        }
+
+        if( count != length / R || cic.shift != shift ) ++mismatches;
+        for( int32_t m = 0; m < count; ++m )
+            mismatches += test_output[m] != (int32_t)(sums[N][m * R + R - 1] >> shift);
+        sprintf( name, "dsp_filters_cic_decimate R=%d N=%d shift=%d", R, N, cic.shift );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+static int32_t test_fir_fixed_kernel( int32_t taps, uint32_t* seed )
+{
+    int32_t mismatches = 0;
+
+    for( int32_t i = 0; i < taps; ++i ) test_coeffs[i] = random_sample( seed, 8 );
+    for( int32_t i = 0; i < taps; ++i ) test_state[i] = test_state2[i] = 0;
+    for( int32_t n = 0; n < 2 * taps; ++n )
+    {
+        int32_t x = random_sample( seed, 1 ), y;
+
+        switch( taps )
+        {
+            case 16:  y = dsp_filters_fir_16( x, test_coeffs, test_state2, 31 ); break;
+            case 24:  y = dsp_filters_fir_24( x, test_coeffs, test_state2, 31 ); break;
+            case 32:  y = DSP_FILTERS_FIR_FIXED( x, test_coeffs, test_state2, 32, 31 ); break;
+            case 64:  y = dsp_filters_fir_64( x, test_coeffs, test_state2, 31 ); break;
+            default:  y = dsp_filters_fir_128( x, test_coeffs, test_state2, 31 ); break;
+        }
+        mismatches += y != dsp_filters_fir( x, test_coeffs, test_state, taps, 31 );
+    }
+    for( int32_t i = 0; i < taps - 1; ++i ) mismatches += test_state[i] != test_state2[i];
+    return mismatches;
+}
+
+static void test_fir_fixed( void )
+{
+    const int32_t sizes[5] = { 16, 24, 32, 64, 128 };
+    uint32_t seed = 9;
+
+    printf( "\nFixed-length FIR\n" );
+    for( int32_t k = 0; k < 5; ++k )
+    {
+        char name[64];
+
+        // The 32-tap case goes through the selection macro
+        sprintf( name, sizes[k] == 32 ? "DSP_FILTERS_FIR_FIXED num_taps=%d" : "dsp_filters_fir_%d", sizes[k] );
+        print_mismatches( name, test_fir_fixed_kernel( sizes[k], &seed ) );
+    }
+}
+
+
+
+// The 16-bit coefficient filters equal the 32-bit ones given b << 16 and
+// q_format + 16
+
+static void test_c16( void )
+{
+    int32_t mismatches = 0;
+    uint32_t seed = 10;
+    char name[64];
+
+    printf( "\n16-bit Coefficient Filters\n" );
+    for( int32_t taps = 1; taps <= 19; ++taps )
+    {
+        for( int32_t i = 0; i < taps; ++i )
+        {
+            test_coeffs16[i] = (int16_t) random_sample( &seed, 16 );
+            test_coeffs[i] = test_coeffs16[i] << 16;
+        }
+        for( int32_t i = 0; i < taps; ++i ) test_state[i] = test_state2[i] = 0;
+        for( int32_t n = 0; n < 2 * taps; ++n )
+        {
+            int32_t x = random_sample( &seed, 1 );
+            mismatches += dsp_filters_fir_c16( x, test_coeffs16, test_state2, taps, 15 )
+                       != dsp_filters_fir( x, test_coeffs, test_state, taps, 31 );
+        }
+        for( int32_t i = 0; i < taps - 1; ++i ) mismatches += test_state[i] != test_state2[i];
+    }
+    print_mismatches( "dsp_filters_fir_c16 taps=1..19", mismatches );
+
+    for( int32_t r = 2; r <= 4; ++r )
+    {
+        int32_t taps = 8 * r;
+
+        mismatches = 0;
+        for( int32_t i = 0; i < taps; ++i )
+        {
+            test_coeffs16[i] = (int16_t) random_sample( &seed, 16 );
+            test_coeffs[i] = test_coeffs16[i] << 16;
+        }
+        for( int32_t i = 0; i < taps; ++i ) test_state[i] = test_state2[i] = 0;
+        for( int32_t n = 0; n < TEST_SAMPLE_LENGTH; ++n )
+        {
+            int32_t x = random_sample( &seed, 1 );
+            dsp_filters_interpolate( x, test_coeffs, test_state, taps, r, test_output, 31 );
+            dsp_filters_interpolate_c16( x, test_coeffs16, test_state2, taps, r, test_output2, 15 );
+            for( int32_t i = 0; i < r; ++i ) mismatches += test_output[i] != test_output2[i];
+        }
+        sprintf( name, "dsp_filters_interpolate_c16 taps=%d L=%d", taps, r );
+        print_mismatches( name, mismatches );
+    }
+
+    for( int32_t r = 2; r <= 4; ++r )
+    {
+        int32_t taps = 12;
+
+        mismatches = 0;
+        for( int32_t i = 0; i < taps; ++i )
+        {
+            test_coeffs16[i] = (int16_t) random_sample( &seed, 16 );
+            test_coeffs[i] = test_coeffs16[i] << 16;
+        }
+        for( int32_t i = 0; i < taps; ++i ) test_state[i] = test_state2[i] = 0;
+        for( int32_t n = 0; n < TEST_SAMPLE_LENGTH / r; ++n )
+        {
+            for( int32_t i = 0; i < r; ++i ) test_input[i] = random_sample( &seed, 1 );
+            mismatches += dsp_filters_decimate_c16( test_input, test_coeffs16, test_state2, taps, r, 15 )
+                       != dsp_filters_decimate( test_input, test_coeffs, test_state, taps, r, 31 );
+        }
+        for( int32_t i = 0; i < taps - 1; ++i ) mismatches += test_state[i] != test_state2[i];
+        sprintf( name, "dsp_filters_decimate_c16 taps=%d M=%d", taps, r );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+// The all-zero lattice followed by the all-pole lattice reconstructs the
+// input to within the rounding of the stage products
+
+static void test_lattice( void )
+{
+    static int32_t k[8], v[9], state[3][8];
+    uint32_t seed = 11;
+
+    printf( "\nLattice Filters\n" );
+    for( int32_t order = 1; order <= 7; ++order )
+    {
+        int32_t max_error = 0, mismatches = 0;
+        char name[64];
+
+        for( int32_t m = 0; m < order; ++m ) k[m] = random_sample( &seed, 2 );
+        for( int32_t m = 0; m < 8; ++m ) state[0][m] = state[1][m] = 0;
+        for( int32_t n = 0; n < 1000; ++n )
+        {
+            int32_t x = random_sample( &seed, 7 );
+            int32_t y = dsp_filters_lattice_allzero( x, k, state[0], order, 30 );
+            int32_t error = dsp_filters_lattice_allpole( y, k, state[1], order, 30 ) - x;
+            if( error < 0 ) error = -error;
+            if( error > max_error ) max_error = error;
+        }
+        printf( "dsp_filters_lattice_allpole inverse order=%d: %s\n", order,
+                max_error <= order ? "PASS" : "FAIL" );
+
+        // Block forms against the per-sample forms, and a ladder that only
+        // takes g[0] against the all-pole output
+        for( int32_t m = 0; m <= order; ++m ) v[m] = 0;
+        v[0] = 1 << 30;
+        for( int32_t m = 0; m < 8; ++m ) state[0][m] = state[1][m] = state[2][m] = 0;
+        for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 7 );
+        dsp_filters_lattice_allzero_block( test_input, test_output, TEST_SAMPLE_LENGTH, k, state[0], order, 30 );
+        dsp_filters_lattice_allpole_block( test_input, test_output2, TEST_SAMPLE_LENGTH, k, state[1], order, 30 );
+        for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+            mismatches += test_output2[i] != dsp_filters_lattice_ladder( test_input[i], k, v, state[2], order, 30 );
+        for( int32_t m = 0; m < 8; ++m ) state[1][m] = state[2][m] = 0;
+        for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+            mismatches += test_output[i] != dsp_filters_lattice_allzero( test_input[i], k, state[1], order, 30 );
+        dsp_filters_lattice_ladder_block( test_input, test_output, TEST_SAMPLE_LENGTH, k, v, state[2], order, 30 );
+        for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) mismatches += test_output[i] != test_output2[i];
+        sprintf( name, "dsp_filters_lattice blocks and ladder order=%d", order );
+        print_mismatches( name, mismatches );
+    }
+}
+
+
+
+// Direct references: the rounded mean of the window, and the middle of the
+// sorted window. Every seventh input is full scale to exercise the extremes.
+// The block forms are then run from fresh state on the same input.
+
+static void test_moving_average_median( void )
+{
+    const int32_t lengths[5] = { 1, 4, 5, 16, 17 };
+    const int32_t length = 8 * TEST_SAMPLE_LENGTH;
+    static int32_t average_buffer[17], median_buffer[3 * 17], window[17];
+    static int32_t average_output[8 * TEST_SAMPLE_LENGTH], median_output[8 * TEST_SAMPLE_LENGTH];
+    dsp_filters_moving_average_t average;
+    dsp_filters_median_t median;
+    uint32_t seed = 12;
+
+    printf( "\nMoving Average and Median\n" );
+    for( int32_t k = 0; k < 5; ++k )
+    {
+        int32_t N = lengths[k], average_mismatches = 0, median_mismatches = 0;
+        char name[64];
+
+        dsp_filters_moving_average_init( &average, average_buffer, N );
+        dsp_filters_median_init( &median, median_buffer, N );
+        for( int32_t i = 0; i < length; ++i )
+        {
+            int32_t x = random_sample( &seed, 20 );
+            int64_t sum = 0, rounded;
+
+            if( i % 7 == 0 ) x = x < 0 ? INT32_MIN : INT32_MAX;
+            test_output[i] = x;
+            average_output[i] = dsp_filters_moving_average( &average, x );
+            median_output[i] = dsp_filters_median( &median, x );
+
+            // Insertion sort of the window, with zeros before the first input
+            for( int32_t j = 0; j < N; ++j )
+            {
+                int32_t value = i >= j ? test_output[i - j] : 0, w = j;
+                for( ; w > 0 && window[w - 1] > value; --w ) window[w] = window[w - 1];
+                window[w] = value;
+                sum += value;
+            }
+            rounded = (2 * sum + N) / (2 * N) - ((2 * sum + N) % (2 * N) < 0);
+            average_mismatches += average_output[i] != rounded;
+            median_mismatches += median_output[i] != (N & 1 ? window[N / 2] :
+                (int32_t)(((int64_t) window[N / 2 - 1] + window[N / 2]) >> 1));
+        }
+
+        dsp_filters_moving_average_init( &average, average_buffer, N );
+        dsp_filters_moving_average_block( &average, test_output, test_output2, length );
+        for( int32_t i = 0; i < length; ++i ) average_mismatches += test_output2[i] != average_output[i];
+        dsp_filters_median_init( &median, median_buffer, N );
+        dsp_filters_median_block( &median, test_output, test_output2, length );
+        for( int32_t i = 0; i < length; ++i ) median_mismatches += test_output2[i] != median_output[i];
+
+        sprintf( name, "dsp_filters_moving_average N=%d", N );
+        print_mismatches( name, average_mismatches );
+        sprintf( name, "dsp_filters_median N=%d", N );
+        print_mismatches( name, median_mismatches );
+    }
+}
+
+
+
+// Sparse FIR against dsp_filters_fir() with the dense coefficients that
+// survive the threshold. 200 taps with about one in eight significant and
+// the rest tiny or zero; four frames of input wrap the 256 word history.
+
+static void test_sparse_fir( void )
+{
+    static uint32_t delays[200];
+    static int32_t  coeffs[200];
+    static int32_t  history[256];
+    dsp_filters_sparse_fir_t filter;
+    uint32_t seed = 1;
+    int32_t  num_taps, count_mismatches = 0, mismatches = 0, block_mismatches = 0;
+
+    printf( "\nSparse FIR\n" );
+    for( int32_t i = 0; i < 200; ++i )
+    {
+        uint32_t r = (uint32_t) random_sample( &seed, 0 ) >> 28;
+        test_coeffs[i] = r < 2 ? random_sample( &seed, 3 ) : r < 6 ? random_sample( &seed, 30 ) : 0;
+    }
+    // The count is returned even when the arrays are too small
+    num_taps = dsp_filters_sparse_fir_from_dense( test_coeffs, 200, 2, delays, coeffs, 3 );
+    count_mismatches += dsp_filters_sparse_fir_from_dense( test_coeffs, 200, 2, delays, coeffs, 200 ) != num_taps;
+
+    // Keep the taps above the threshold in the dense reference
+    for( int32_t i = 0; i < 200; ++i )
+    {
+        test_state2[i] = test_coeffs[i];
+        test_coeffs[i] = 0;
+    }
+    for( int32_t t = 0; t < num_taps; ++t ) test_coeffs[delays[t]] = coeffs[t];
+    for( int32_t i = 0; i < 200; ++i )
+        count_mismatches += test_coeffs[i] != (test_state2[i] < -2 || test_state2[i] > 2 ? test_state2[i] : 0);
+
+    for( int32_t i = 0; i < 256; ++i ) test_state[i] = 0;
+    dsp_filters_sparse_fir_init( &filter, delays, coeffs, num_taps, history, 256, 28 );
+    for( int32_t frame = 0; frame < 4; ++frame )
+    {
+        for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i ) test_input[i] = random_sample( &seed, 2 );
+        if( frame & 1 )
+        {
+            dsp_filters_sparse_fir_block( &filter, test_input, test_output2, TEST_SAMPLE_LENGTH );
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+                block_mismatches += test_output2[i] != dsp_filters_fir( test_input[i], test_coeffs, test_state, 200, 28 );
+        }
+        else
+        {
+            for( int32_t i = 0; i < TEST_SAMPLE_LENGTH; ++i )
+                mismatches += dsp_filters_sparse_fir( &filter, test_input[i] ) !=
+                              dsp_filters_fir( test_input[i], test_coeffs, test_state, 200, 28 );
+        }
+    }
+    print_mismatches( "dsp_filters_sparse_fir_from_dense", count_mismatches );
+    print_mismatches( "dsp_filters_sparse_fir", mismatches );
+    print_mismatches( "dsp_filters_sparse_fir_block", block_mismatches );
+}
+
+
+
+// Delay line: blocks of 1 to 13 samples wrap the 64 sample buffer at every
+// alignment. Integer and linear reads have exact references; the cubic and
+// windowed sinc polyphase reads are checked against the delayed sinusoid.
+
+#define DELAY_LENGTH      64
+#define DELAY_TAPS        5
+#define DELAY_PHASES      32
+#define DELAY_SUBFILTER   8
+#define DELAY_AMPLITUDE   (1 << 29)
+#define DELAY_FREQUENCY   0.02
+
+static double delayed_sine( int32_t newest, uint32_t delay )
+{
+    return DELAY_AMPLITUDE * sin( 2 * M_PI * DELAY_FREQUENCY * (newest - delay / 65536.0) );
+}
+
+static void test_delay_line( void )
+{
+    // Delays in samples with DSP_DELAY_LINE_FRAC_BITS fractional bits
+    const uint32_t delays[DELAY_TAPS] = { (3 << 16) + 12345, (10 << 16) + 40000, 20 << 16,
+                                          (40 << 16) + 65535, (5 << 16) + 32768 };
+    static int32_t history[40 * 13];
+    dsp_delay_line_t line, line2;
+    int32_t blocks_match = 1, integer_match = 1, linear_match = 1;
+    double  cubic_error = 0, poly_error = 0;
+    int32_t n = 0;
+
+    printf( "\nDelay Line\n" );
+
+    // Windowed sinc sub-filters, sub-filter p delaying by DELAY_SUBFILTER/2 - 1 + p/DELAY_PHASES
+    for( int32_t p = 0; p < DELAY_PHASES; ++p )
+    {
+        for( int32_t k = 0; k < DELAY_SUBFILTER; ++k )
+        {
+            double t = k - (DELAY_SUBFILTER / 2 - 1) - (double) p / DELAY_PHASES;
+            double s = t == 0 ? 1 : sin( M_PI * t ) / (M_PI * t);
+            double w = 0.5 + 0.5 * cos( M_PI * t / (DELAY_SUBFILTER / 2 + 0.5) );
+            test_coeffs[p * DELAY_SUBFILTER + k] = (int32_t) floor( s * w * (1 << 30) + 0.5 );
+        }
+    }
+
+    dsp_delay_line_init( &line, test_state, DELAY_LENGTH );
+    dsp_delay_line_init( &line2, test_state2, DELAY_LENGTH );
+
+    for( int32_t b = 0; b < 40; ++b )
+    {
+        int32_t length = 1 + b % 13, newest;
+        uint32_t integer_delays[DELAY_TAPS];
+
+        for( int32_t i = 0; i < length; ++i, ++n )
+            history[n] = test_input[i] =
+                (int32_t) floor( DELAY_AMPLITUDE * sin( 2 * M_PI * DELAY_FREQUENCY * n ) + 0.5 );
+        dsp_delay_line_write_block( &line, test_input, length );
+        for( int32_t i = 0; i < length; ++i ) dsp_delay_line_write( &line2, test_input[i] );
+        for( int32_t i = 0; i < DELAY_LENGTH; ++i ) blocks_match &= test_state[i] == test_state2[i];
+        if( n < DELAY_LENGTH ) continue;
+        newest = n - 1;
+
+        for( int32_t t = 0; t < DELAY_TAPS; ++t ) integer_delays[t] = delays[t] >> 16;
+        dsp_delay_line_read( &line, integer_delays, test_output, DELAY_TAPS );
+        for( int32_t t = 0; t < DELAY_TAPS; ++t )
+            integer_match &= test_output[t] == history[newest - integer_delays[t]];
+
+        // Linear interpolation has an exact integer reference
+        dsp_delay_line_read_linear( &line, delays, test_output, DELAY_TAPS );
+        for( int32_t t = 0; t < DELAY_TAPS; ++t )
+        {
+            int64_t w1 = (delays[t] & 0xFFFF) << 14, w0 = (1 << 30) - w1;
+            int32_t d  = delays[t] >> 16;
+            int64_t y  = w0 * history[newest - d] + w1 * history[newest - d - 1] + (1 << 29);
+            linear_match &= test_output[t] == (int32_t)(y >> 30);
+        }
+
+        dsp_delay_line_read_cubic( &line, delays, test_output, DELAY_TAPS );
+        for( int32_t t = 0; t < DELAY_TAPS; ++t )
+            cubic_error = fmax( cubic_error, fabs( test_output[t] - delayed_sine( newest, delays[t] ) ) );
+
+        dsp_delay_line_read_polyphase( &line, delays, test_output, DELAY_TAPS,
+                                       test_coeffs, DELAY_PHASES, DELAY_SUBFILTER, 30 );
+        for( int32_t t = 0; t < DELAY_TAPS; ++t )
+            poly_error = fmax( poly_error, fabs( test_output[t] - delayed_sine( newest, delays[t] ) ) );
+    }
+
+    report( "dsp_delay_line_write_block matches dsp_delay_line_write", blocks_match );
+    report( "dsp_delay_line_read integer delays", integer_match );
+    report( "dsp_delay_line_read_linear bit-exact", linear_match );
+    report( "dsp_delay_line_read_cubic error below 1e-4 of full scale", cubic_error < DELAY_AMPLITUDE * 1e-4 );
+    // Rounding to the nearest of 32 phases costs up to 2*pi*0.02/64 = 2e-3
+    report( "dsp_delay_line_read_polyphase error below 4e-3 of full scale",
+            poly_error < DELAY_AMPLITUDE * 4e-3 );
+}
+
+
+
+// Filterbank: analysis followed by synthesis reconstructs the input delayed
+// by length - hop. Returns the signal to error ratio in dB once the history
+// has filled.
+
+#define FILTERBANK_SAMPLES  2048
+
+static int32_t filterbank_inputs[FILTERBANK_SAMPLES];
+static int32_t filterbank_outputs[FILTERBANK_SAMPLES];
+static dsp_complex_t filterbank_spectrum[16];
+
+static double filterbank_snr( int32_t num_bands, int32_t hop, int32_t length )
+{
+    dsp_filterbank_t fb;
+    uint32_t seed = 1;
+    int32_t delay = length - hop;
+    double signal = 0, error = 0;
+
+    dsp_design_filterbank_prototype( num_bands, hop, test_coeffs, length, 30 );
+    dsp_filterbank_init( &fb, test_coeffs, length, num_bands, hop, test_state, test_state2, 30 );
+    for( int32_t i = 0; i < FILTERBANK_SAMPLES; ++i ) filterbank_inputs[i] = random_sample( &seed, 4 );
+    for( int32_t f = 0; f < FILTERBANK_SAMPLES; f += hop )
+    {
+        dsp_filterbank_analyse( &fb, filterbank_inputs + f, filterbank_spectrum );
+        dsp_filterbank_synthesise( &fb, filterbank_spectrum, filterbank_outputs + f );
+    }
+    for( int32_t i = delay + length; i < FILTERBANK_SAMPLES; ++i )
+    {
+        double d = (double) filterbank_outputs[i] - filterbank_inputs[i - delay];
+        signal += (double) filterbank_inputs[i - delay] * filterbank_inputs[i - delay];
+        error  += d * d;
+    }
+    return 10 * log10( signal / error );
+}
+
+static void test_filterbank( void )
+{
+    dsp_filterbank_t fb;
+    double in_band = 0, two_away = 0;
+
+    printf( "\nFilterbank\n" );
+    report( "dsp_filterbank reconstruction K=16 R=8 L=64 above 35 dB",
+            filterbank_snr( 16, 8, 64 ) > 35 );
+    report( "dsp_filterbank reconstruction K=16 R=8 L=128 above 45 dB",
+            filterbank_snr( 16, 8, 128 ) > 45 );
+    report( "dsp_filterbank reconstruction K=32 R=16 L=128 above 35 dB",
+            filterbank_snr( 32, 16, 128 ) > 35 );
+
+    // A cosine at the centre of band 3 leaks little into band 5
+    dsp_design_filterbank_prototype( 16, 8, test_coeffs, 128, 30 );
+    dsp_filterbank_init( &fb, test_coeffs, 128, 16, 8, test_state, test_state2, 30 );
+    for( int32_t f = 0; f < 200 * 8; f += 8 )
+    {
+        for( int32_t i = 0; i < 8; ++i )
+            test_input[i] = (int32_t) floor( (1 << 27) * cos( 2 * M_PI * 3 / 16 * (f + i) ) + 0.5 );
+        dsp_filterbank_analyse( &fb, test_input, filterbank_spectrum );
+        if( f < 128 ) continue;
+        in_band  += hypot( filterbank_spectrum[3].re, filterbank_spectrum[3].im );
+        two_away += hypot( filterbank_spectrum[5].re, filterbank_spectrum[5].im );
+    }
+    report( "dsp_filterbank_analyse band 5 below band 3 by 60 dB",
+            20 * log10( two_away / in_band ) < -60 );
+
+    report( "dsp_filterbank_init rejects num_bands 12",
+            dsp_filterbank_init( &fb, test_coeffs, 48, 12, 6, test_state, test_state2, 30 ) == -1 );
+    report( "dsp_filterbank_init rejects hop not dividing num_bands",
+            dsp_filterbank_init( &fb, test_coeffs, 64, 16, 6, test_state, test_state2, 30 ) == -1 );
+    report( "dsp_filterbank_init rejects length not a multiple of num_bands",
+            dsp_filterbank_init( &fb, test_coeffs, 72, 16, 8, test_state, test_state2, 30 ) == -1 );
+    report( "dsp_filterbank_init accepts K=16 R=8 L=128",
+            dsp_filterbank_init( &fb, test_coeffs, 128, 16, 8, test_state, test_state2, 30 ) == 0 );
+}
+
+
+
+void filters_tests( void )
+{
+    test_interpolate_block();
+    test_resampler();
+    test_asrc();
+    test_biquads_multichannel();
+    test_biquads_block();
+    test_biquad_ef();
+    test_biquad_smooth();
+    test_cic();
+    test_fir_fixed();
+    test_c16();
+    test_lattice();
+    test_moving_average_median();
+    test_sparse_fir();
+    test_delay_line();
+    test_filterbank();
+}
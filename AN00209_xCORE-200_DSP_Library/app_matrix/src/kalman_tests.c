@@ -0,0 +1,248 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+// XMOS DSP Library - Kalman Filter Functions Test Program, self-checking tests
+// Written in C because the filter object holds pointers to its arrays
+
+// Include files
+#include <stdio.h>
+#include <math.h>
+#include <dsp.h>
+
+#define NUM_STEPS      2000
+#define Q_FORMAT       24
+#define DT             0.0625
+#define AMPLITUDE      10.0
+#define FREQUENCY      0.002
+#define NOISE          1.0
+
+// Arrays passed to the filters are global to keep them 64-bit aligned
+int32_t states[3][4];
+int32_t covariances[3][16];
+int32_t states2[3][4];
+int32_t covariances2[3][16];
+int32_t transition[2][16];
+int32_t process_noise[2][16];
+int32_t observation[2][8];
+int32_t measurement_noise[2][2];
+int32_t scratch[16];
+int32_t measurements[8];
+
+// Floating point model and filter, the same equations without rounding
+double f_transition[16];
+double f_process_noise[16];
+double f_observation[8];
+double f_measurement_noise[2];
+double f_state[4];
+double f_covariance[16];
+
+// Uniform pseudo-random sample of 32 - shift bits, the same on every target
+static int32_t random_sample( uint32_t* seed, int32_t shift )
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (int32_t) *seed >> shift;
+}
+
+static void report( const char* name, int32_t pass )
+{
+    printf( "%s: %s\n", name, pass ? "PASS" : "FAIL" );
+}
+
+static int32_t to_fixed( double value )
+{
+    return (int32_t) floor( value * (1 << Q_FORMAT) + 0.5 );
+}
+
+// Constant velocity model of n / 2 independent axes, each with position and
+// velocity states; measurement j observes the position of axis j. The
+// floating point model is written alongside fixed point model number
+// ``model``.
+static void make_model( int32_t model, int32_t n, int32_t m )
+{
+    for( int32_t i = 0; i < n * n; ++i ) f_transition[i] = f_process_noise[i] = 0;
+    for( int32_t i = 0; i < m * n; ++i ) f_observation[i] = 0;
+    for( int32_t a = 0; a < n; a += 2 )
+    {
+        f_transition[a*n + a] = f_transition[(a+1)*n + a+1] = 1;
+        f_transition[a*n + a+1] = DT;
+        f_process_noise[a*n + a]       = DT * DT * DT / 3;
+        f_process_noise[a*n + a+1]     = f_process_noise[(a+1)*n + a] = DT * DT / 2;
+        f_process_noise[(a+1)*n + a+1] = DT;
+    }
+    for( int32_t j = 0; j < m; ++j )
+    {
+        f_observation[j*n + 2*j] = 1;
+        f_measurement_noise[j]   = NOISE * NOISE / 3 / (j + 1);
+    }
+    for( int32_t i = 0; i < n * n; ++i )
+    {
+        transition[model][i]    = to_fixed( f_transition[i] );
+        process_noise[model][i] = to_fixed( f_process_noise[i] );
+    }
+    for( int32_t i = 0; i < m * n; ++i ) observation[model][i] = to_fixed( f_observation[i] );
+    for( int32_t j = 0; j < m; ++j ) measurement_noise[model][j] = to_fixed( f_measurement_noise[j] );
+}
+
+static void reset( int32_t* state, int32_t* covariance, int32_t n )
+{
+    for( int32_t i = 0; i < n; ++i ) state[i] = 0;
+    for( int32_t i = 0; i < n * n; ++i ) covariance[i] = (i % (n + 1)) ? 0 : to_fixed( 10 );
+}
+
+static void f_predict( int32_t n )
+{
+    double x[4], T[16];
+
+    for( int32_t i = 0; i < n; ++i )
+    {
+        x[i] = 0;
+        for( int32_t k = 0; k < n; ++k ) x[i] += f_transition[i*n + k] * f_state[k];
+    }
+    for( int32_t i = 0; i < n; ++i ) f_state[i] = x[i];
+    for( int32_t i = 0; i < n; ++i )
+        for( int32_t j = 0; j < n; ++j )
+        {
+            T[i*n + j] = 0;
+            for( int32_t k = 0; k < n; ++k ) T[i*n + j] += f_transition[i*n + k] * f_covariance[k*n + j];
+        }
+    for( int32_t i = 0; i < n; ++i )
+        for( int32_t j = 0; j < n; ++j )
+        {
+            f_covariance[i*n + j] = f_process_noise[i*n + j];
+            for( int32_t k = 0; k < n; ++k ) f_covariance[i*n + j] += T[i*n + k] * f_transition[j*n + k];
+        }
+}
+
+static void f_update( int32_t n, int32_t m, const double* z )
+{
+    for( int32_t r = 0; r < m; ++r )
+    {
+        const double* h = f_observation + r*n;
+        double u[4], k[4], s = f_measurement_noise[r], innovation = z[r];
+
+        for( int32_t i = 0; i < n; ++i )
+        {
+            u[i] = 0;
+            for( int32_t j = 0; j < n; ++j ) u[i] += f_covariance[i*n + j] * h[j];
+        }
+        for( int32_t i = 0; i < n; ++i ) s += h[i] * u[i];
+        for( int32_t i = 0; i < n; ++i ) innovation -= h[i] * f_state[i];
+        for( int32_t i = 0; i < n; ++i ) k[i] = u[i] / s;
+        for( int32_t i = 0; i < n; ++i ) f_state[i] += k[i] * innovation;
+        for( int32_t i = 0; i < n; ++i )
+            for( int32_t j = 0; j < n; ++j )
+                f_covariance[i*n + j] += -k[i] * u[j] - u[i] * k[j] + s * k[i] * k[j];
+    }
+}
+
+// Track a sinusoidal trajectory, with a different phase on each axis, from
+// noisy positions with the fixed point filter and the floating point
+// reference. Returns the largest state and covariance differences, and the
+// mean squared position error of the estimate relative to that of the raw
+// measurements.
+static void track( int32_t n, int32_t m, double* state_error, double* covariance_error,
+                   double* error_ratio )
+{
+    dsp_kalman_t kf;
+    uint32_t seed = 1;
+    double estimate_error = 0, measurement_error = 0;
+
+    make_model( 0, n, m );
+    reset( states[0], covariances[0], n );
+    for( int32_t i = 0; i < n; ++i ) f_state[i] = 0;
+    for( int32_t i = 0; i < n * n; ++i ) f_covariance[i] = (i % (n + 1)) ? 0 : 10;
+    dsp_kalman_init( &kf, n, m, states[0], covariances[0], transition[0], process_noise[0],
+                     observation[0], measurement_noise[0], scratch, Q_FORMAT );
+    *state_error = *covariance_error = 0;
+
+    for( int32_t t = 0; t < NUM_STEPS; ++t )
+    {
+        double z[2], position[2];
+
+        for( int32_t j = 0; j < m; ++j )
+        {
+            position[j] = AMPLITUDE * sin( 2 * M_PI * FREQUENCY * t + j );
+            z[j] = position[j] + NOISE * random_sample( &seed, 0 ) / 2147483648.0 / sqrt( j + 1 );
+            measurements[j] = to_fixed( z[j] );
+            z[j] = (double) measurements[j] / (1 << Q_FORMAT);
+        }
+        dsp_kalman_predict( &kf );
+        dsp_kalman_update( &kf, measurements );
+        f_predict( n );
+        f_update( n, m, z );
+
+        for( int32_t i = 0; i < n; ++i )
+            *state_error = fmax( *state_error, fabs( (double) states[0][i] / (1 << Q_FORMAT) - f_state[i] ) );
+        for( int32_t i = 0; i < n * n; ++i )
+            *covariance_error = fmax( *covariance_error,
+                                      fabs( (double) covariances[0][i] / (1 << Q_FORMAT) - f_covariance[i] ) );
+        if( t < NUM_STEPS / 4 ) continue;
+        for( int32_t j = 0; j < m; ++j )
+        {
+            double e = (double) states[0][2*j] / (1 << Q_FORMAT) - position[j];
+            estimate_error    += e * e;
+            measurement_error += (z[j] - position[j]) * (z[j] - position[j]);
+        }
+    }
+    *error_ratio = estimate_error / measurement_error;
+}
+
+void kalman_tests( void )
+{
+    const int32_t sizes[][2] = { { 2, 1 }, { 4, 2 } };
+    const int32_t batch_sizes[3] = { 2, 4, 2 };
+    dsp_kalman_t kf[3], kf2[3];
+    int32_t mismatches = 0;
+    uint32_t seed = 3;
+    char name[80];
+
+    printf( "\nKalman Filter\n" );
+    for( int32_t c = 0; c < 2; ++c )
+    {
+        int32_t n = sizes[c][0], m = sizes[c][1];
+        double state_error, covariance_error, error_ratio;
+
+        track( n, m, &state_error, &covariance_error, &error_ratio );
+        sprintf( name, "dsp_kalman n=%d m=%d state within 1e-4 of floating point", n, m );
+        report( name, state_error < 1e-4 );
+        sprintf( name, "dsp_kalman n=%d m=%d covariance within 1e-5 of floating point", n, m );
+        report( name, covariance_error < 1e-5 );
+        sprintf( name, "dsp_kalman n=%d m=%d position error below 1/4 of measurement error", n, m );
+        report( name, error_ratio < 0.25 );
+    }
+
+    // Filters of different sizes, the 2-state ones sharing model arrays, and
+    // all sharing the scratch matrix
+    make_model( 0, 2, 1 );
+    make_model( 1, 4, 2 );
+    for( int32_t f = 0; f < 3; ++f )
+    {
+        int32_t n = batch_sizes[f], model = n / 2 - 1;
+        reset( states[f], covariances[f], n );
+        reset( states2[f], covariances2[f], n );
+        dsp_kalman_init( &kf[f], n, n / 2, states[f], covariances[f], transition[model],
+                         process_noise[model], observation[model], measurement_noise[model],
+                         scratch, Q_FORMAT );
+        dsp_kalman_init( &kf2[f], n, n / 2, states2[f], covariances2[f], transition[model],
+                         process_noise[model], observation[model], measurement_noise[model],
+                         scratch, Q_FORMAT );
+    }
+    for( int32_t t = 0; t < NUM_STEPS / 4; ++t )
+    {
+        int32_t* z = measurements;
+
+        for( int32_t i = 0; i < 4; ++i ) measurements[i] = random_sample( &seed, 4 );
+        dsp_kalman_step_batch( kf, measurements, 3 );
+        for( int32_t f = 0; f < 3; ++f )
+        {
+            dsp_kalman_predict( &kf2[f] );
+            dsp_kalman_update( &kf2[f], z );
+            z += kf2[f].num_measurements;
+        }
+        for( int32_t f = 0; f < 3; ++f )
+        {
+            int32_t n = batch_sizes[f];
+            for( int32_t i = 0; i < n; ++i ) mismatches += states[f][i] != states2[f][i];
+            for( int32_t i = 0; i < n * n; ++i ) mismatches += covariances[f][i] != covariances2[f][i];
+        }
+    }
+    printf( "dsp_kalman_step_batch: %d mismatches\n", mismatches );
+}
@@ -6,13 +6,16 @@
 #include <dsp_adaptive.h>
 #include <dsp_design.h>
 #include <dsp_filters.h>
+#include <dsp_delay.h>
 #include <dsp_matrix.h>
+#include <dsp_kalman.h>
 #include <dsp_statistics.h>
 #include <dsp_math.h>
 #include <dsp_math_int.h>
 #include <dsp_qformat.h>
 #include <dsp_vector.h>
 #include <dsp_fft.h>
+#include <dsp_filterbank.h>
 #include <dsp_bfp.h>
 #include <dsp_dct.h>
 
@@ -4,6 +4,9 @@
 #define DSP_ADAPTIVE_H_
 
 #include <stdint.h>
+#include "xccompat.h"
+#include "dsp_complex.h"
+#include "dsp_filterbank.h"
 
 #ifdef __XC__
 extern "C" {
@@ -79,6 +82,73 @@ int32_t dsp_adaptive_lms
     int32_t q_format
 );
 
+/** This function implements a least-mean-squares adaptive FIR filter that
+ *  filters and updates its coefficients in a single pass.
+ *
+ *  dsp_adaptive_lms() makes two passes over the ``N`` taps per sample: the
+ *  FIR filter and then the coefficient update. This function instead defers
+ *  the update of each sample to the start of the next call, where it is
+ *  applied in the same sweep as the FIR filter, so each coefficient and state
+ *  word is loaded and stored once per sample. Per sample:
+ *
+ *  \code
+ *  1) delta = mu * previous error
+ *  2) For each tap: FIR_COEFFS[n] = FIR_COEFFS[n] + FIR_STATE[n] * delta,
+ *     then shift FIR_STATE along and accumulate FIR_COEFFS[n] * FIR_STATE[n]
+ *  3) error = reference - output
+ *  \endcode
+ *
+ *  The previous error is passed in through ``error_sample``, which therefore
+ *  carries the filter state between calls. As the update uses the state
+ *  before it is shifted, i.e. the input the previous error was measured with,
+ *  the output and error follow the same LMS recursion as dsp_adaptive_lms()
+ *  with the same rounding of each product; only the coefficient array lags by
+ *  one update between calls.
+ *
+ *  Example of a 100-tap fused LMS filter with samples and coefficients
+ *  represented in Q28 fixed-point format:
+ *
+ *  \code
+ *  int32_t filter_coeff[100] = { ... not shown for brevity };
+ *  int32_t filter_state[100] = { 0, 0, 0, 0, ... not shown for brevity };
+ *  int32_t error_sample = 0;
+ *
+ *  int32_t output_sample = dsp_adaptive_lms_fused
+ *  (
+ *    input_sample, reference_sample, &error_sample,
+ *    filter_coeff_array, filter_state_array, 100, Q28(0.01), 28
+ *  );
+ *  \endcode
+ *
+ *  \param  input_sample      The new sample to be processed.
+ *  \param  reference_sample  Reference sample.
+ *  \param  error_sample      Pointer to the error sample. On entry the error
+ *                            returned by the previous call (zero before the
+ *                            first call); on return the new error
+ *                            (error = reference - output).
+ *  \param  filter_coeffs     Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *                            Must be double-word aligned.
+ *  \param  state_data        Pointer to FIR filter state data array of length ``N``.
+ *                            Must be double-word aligned and initialized at
+ *                            startup to all zeros.
+ *  \param  num_taps          Filter tap count where ``N`` = ``num_taps`` = filter order + 1.
+ *  \param  mu                Coefficient adjustment step size, controls rate of convergence.
+ *  \param  q_format          Fixed point format (i.e. number of fractional bits).
+ *  \returns                  The resulting filter output sample.
+ */
+
+int32_t dsp_adaptive_lms_fused
+(
+    int32_t input_sample,
+    int32_t reference_sample,
+    int32_t *error_sample,
+    const int32_t filter_coeffs[],
+    int32_t state_data[],
+    const int32_t num_taps,
+    const int32_t mu,
+    int32_t q_format
+);
+
 /** This function implements a normalized LMS FIR filter. LMS filters are a class of
  *  adaptive filters that adjust filter coefficients in order to create the a transfer function that
  *  minimizes the error between the input and reference signals. FIR coefficients are adjusted on a 
@@ -155,6 +225,781 @@ int32_t dsp_adaptive_nlms
     int32_t q_format
 );
 
+/** Running input energy of an NLMS filter.
+ *
+ *  Holds the sum of squares of the filter state so that
+ *  dsp_adaptive_nlms_running() can update it in constant time. Initialise
+ *  with dsp_adaptive_nlms_energy_init() and do not modify the members
+ *  directly.
+ */
+typedef struct {
+    int64_t sum;           ///< x[n]^2 + ... + x[n-N+1]^2, unshifted.
+    int32_t count;         ///< Samples since the last exact recomputation.
+    int32_t resync_period; ///< Samples between exact recomputations, 0 for never.
+} dsp_adaptive_nlms_energy_t;
+
+/** This function initialises the running energy of an NLMS filter from its
+ *  current state.
+ *
+ *  \param  tracker        Running energy object.
+ *  \param  state_data     FIR filter state data array of length N.
+ *  \param  num_taps       Filter tap count N.
+ *  \param  resync_period  Number of samples between exact recomputations of
+ *                         the energy from the state, or 0 to never recompute.
+ */
+
+void dsp_adaptive_nlms_energy_init
+(
+    REFERENCE_PARAM(dsp_adaptive_nlms_energy_t, tracker),
+    const int32_t state_data[],
+    const int32_t num_taps,
+    const int32_t resync_period
+);
+
+/** This function implements a normalized LMS FIR filter with a running
+ *  input energy.
+ *
+ *  It produces the same output, error and coefficient updates as
+ *  dsp_adaptive_nlms(), but instead of recomputing
+ *  ``E = x[n]^2 + ... + x[n-N+1]^2`` from the whole state on every sample it
+ *  adds the square of the new sample and subtracts the square of the sample
+ *  that leaves the state. This removes one of the three passes over the
+ *  ``N`` taps per sample (FIR, energy and coefficient update).
+ *
+ *  The sum is kept unshifted in 64 bits, so it is exact and does not drift.
+ *  Every ``resync_period`` samples it is nevertheless recomputed from the
+ *  state, which bounds the effect of the state being modified outside the
+ *  filter (for example cleared on a reset) without re-initialising the
+ *  tracker.
+ *
+ *  Example of a 1024-tap NLMS filter that recomputes its energy once per
+ *  1024 samples:
+ *
+ *  \code
+ *  dsp_adaptive_nlms_energy_t energy;
+ *  dsp_adaptive_nlms_energy_init( &energy, filter_state, 1024, 1024 );
+ *
+ *  int32_t output_sample = dsp_adaptive_nlms_running
+ *  (
+ *    input_sample, reference_sample, &error_sample,
+ *    filter_coeff, filter_state, 1024, Q28(0.01), 28, &energy
+ *  );
+ *  \endcode
+ *
+ *  \param  input_sample      The new sample to be processed.
+ *  \param  reference_sample  Reference sample.
+ *  \param  error_sample      Pointer to resulting error sample (error = reference - output)
+ *  \param  filter_coeffs     Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *  \param  state_data        Pointer to FIR filter state data array of length N.
+ *                            Must be initialized at startup to all zeros.
+ *  \param  num_taps          Filter tap count where N = num_taps = filter order + 1.
+ *  \param  mu                Coefficient adjustment step size, controls rate of convergence.
+ *  \param  q_format          Fixed point format (i.e. number of fractional bits).
+ *  \param  tracker           Running energy object for this filter.
+ *  \returns                  The resulting filter output sample.
+ */
+
+int32_t dsp_adaptive_nlms_running
+(
+    int32_t input_sample,
+    int32_t reference_sample,
+    int32_t *error_sample,
+    const int32_t filter_coeffs[],
+    int32_t state_data[],
+    const int32_t num_taps,
+    const int32_t mu,
+    int32_t q_format,
+    REFERENCE_PARAM(dsp_adaptive_nlms_energy_t, tracker)
+);
+
+/** This function implements an improved proportionate normalized LMS
+ *  (IPNLMS) FIR filter.
+ *
+ *  Echo paths such as those of network echo are sparse: most of the
+ *  coefficients are close to zero. dsp_adaptive_nlms() adapts every tap with
+ *  the same step size and so converges slowly on them. IPNLMS gives each tap
+ *  a step size that grows with the magnitude of its coefficient, so the few
+ *  large taps converge quickly, while a uniform part keeps the small taps
+ *  adapting. Per sample:
+ *
+ *  \code
+ *  1) output = FIR( input ); error = reference - output
+ *  2) g[k] = (1 - alpha) / 2N + (1 + alpha) * |b[k]| / (2 * ||b||_1)
+ *  3) E = g[0] * x[n]^2 + ... + g[N-1] * x[n-N+1]^2
+ *  4) b[k] = b[k] + mu * error * g[k] * x[n-k] / E
+ *  \endcode
+ *
+ *  With ``alpha`` = -1 every gain is 1/N, so the filter behaves like
+ *  dsp_adaptive_nlms() with the same ``mu``, although it is not bit-exact
+ *  with it as E and the update are rounded differently. Values towards 1 make
+ *  the filter more proportionate; -0.5 to 0 suits most echo paths.
+ *
+ *  The gains are not stored: the pass that computes the FIR output also sums
+ *  ``|b[k]|``, ``|b[k]| * x[n-k]^2`` and ``x[n-k]^2``, which give ``||b||_1``
+ *  and ``E`` in closed form, and the coefficient update pass recomputes each
+ *  gain from one reciprocal of ``||b||_1``. That is two passes over the taps,
+ *  one fewer than dsp_adaptive_nlms().
+ *
+ *  Example of a 512-tap IPNLMS filter with alpha = -0.5:
+ *
+ *  \code
+ *  int32_t output_sample = dsp_adaptive_ipnlms
+ *  (
+ *    input_sample, reference_sample, &error_sample,
+ *    filter_coeff, filter_state, 512, Q28(0.5), Q30(-0.5), 28
+ *  );
+ *  \endcode
+ *
+ *  \param  input_sample      The new sample to be processed.
+ *  \param  reference_sample  Reference sample.
+ *  \param  error_sample      Pointer to resulting error sample (error = reference - output)
+ *  \param  filter_coeffs     Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *  \param  state_data        Pointer to FIR filter state data array of length N.
+ *                            Must be initialized at startup to all zeros.
+ *  \param  num_taps          Filter tap count where N = num_taps = filter order + 1.
+ *  \param  mu                Coefficient adjustment step size, controls rate of convergence.
+ *                            The gains sum to one, so 0 < mu < 2 as for
+ *                            dsp_adaptive_nlms().
+ *  \param  alpha             Proportionality in Q30, from -1 up to but not
+ *                            including 1, which would stop the adaptation of
+ *                            zero coefficients.
+ *  \param  q_format          Fixed point format (i.e. number of fractional bits).
+ *  \returns                  The resulting filter output sample.
+ */
+
+int32_t dsp_adaptive_ipnlms
+(
+    int32_t input_sample,
+    int32_t reference_sample,
+    int32_t *error_sample,
+    const int32_t filter_coeffs[],
+    int32_t state_data[],
+    const int32_t num_taps,
+    const int32_t mu,
+    const int32_t alpha,
+    int32_t q_format
+);
+
+#define DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS 8  // Largest channel count of dsp_adaptive_nlms_multi()
+
+/** This function implements a bank of normalized LMS FIR filters that share
+ *  one input.
+ *
+ *  A typical use is multi-microphone echo cancellation: the loudspeaker
+ *  signal is the common ``input_sample`` and each microphone provides one of
+ *  the ``M`` reference samples. Running ``M`` instances of
+ *  dsp_adaptive_nlms() would keep ``M`` identical copies of the state and
+ *  compute the same input energy ``M`` times. Here the state and the running
+ *  energy (see dsp_adaptive_nlms_running()) are kept once, and a single pass
+ *  over the taps loads each state word once, updates all ``M`` coefficient
+ *  sets with it and accumulates all ``M`` outputs.
+ *
+ *  To do this in one pass the coefficient update is delayed by one sample,
+ *  as in dsp_adaptive_lms_fused(): on entry ``error_samples`` holds the
+ *  errors of the previous call, which are applied with the energy of the
+ *  state those errors were measured with before the new outputs are
+ *  computed. Each channel produces the same outputs and errors as
+ *  dsp_adaptive_nlms() would; the coefficients lag by one update until the
+ *  next call. Clear ``error_samples`` before the first call.
+ *
+ *  Example of two 512-tap filters sharing one loudspeaker reference:
+ *
+ *  \code
+ *  int32_t filter_coeffs[2 * 512];  // Channel m starts at filter_coeffs[m * 512]
+ *  int32_t filter_state[512];
+ *  int32_t error_samples[2] = { 0, 0 };
+ *  dsp_adaptive_nlms_energy_t energy;
+ *  dsp_adaptive_nlms_energy_init( &energy, filter_state, 512, 0 );
+ *
+ *  dsp_adaptive_nlms_multi
+ *  (
+ *    loudspeaker_sample, microphone_samples, error_samples, output_samples,
+ *    filter_coeffs, filter_state, 512, 2, Q28(0.01), 28, &energy
+ *  );
+ *  \endcode
+ *
+ *  \param  input_sample       The new sample to be processed, common to all
+ *                             channels.
+ *  \param  reference_samples  The ``M`` reference samples, one per channel.
+ *  \param  error_samples      The ``M`` error samples. On entry the errors of
+ *                             the previous call (zero before the first call),
+ *                             on return the new errors.
+ *  \param  output_samples     The ``M`` resulting filter output samples.
+ *  \param  filter_coeffs      ``M`` sets of ``N`` FIR coefficients, channel
+ *                             ``m`` at ``filter_coeffs[m * N]``; must be
+ *                             double-word aligned.
+ *  \param  state_data         FIR filter state data array of length N, shared
+ *                             by all channels; must be double-word aligned.
+ *                             Must be initialized at startup to all zeros.
+ *  \param  num_taps           Filter tap count N; must be even.
+ *  \param  num_channels       Number of channels M, from 1 to
+ *                             ``DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS``.
+ *  \param  mu                 Coefficient adjustment step size, shared by all
+ *                             channels.
+ *  \param  q_format           Fixed point format (i.e. number of fractional bits).
+ *  \param  tracker            Running energy of ``state_data``.
+ */
+
+void dsp_adaptive_nlms_multi
+(
+    int32_t       input_sample,
+    const int32_t reference_samples[],
+    int32_t       error_samples[],
+    int32_t       output_samples[],
+    int32_t       filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t num_channels,
+    const int32_t mu,
+    int32_t       q_format,
+    REFERENCE_PARAM(dsp_adaptive_nlms_energy_t, tracker)
+);
+
+#define DSP_ADAPTIVE_BLOCK_MAX_LENGTH 64  // Largest frame of dsp_adaptive_lms_block()
+
+/** This function implements a block least-mean-squares adaptive FIR filter
+ *  on a frame of samples.
+ *
+ *  dsp_adaptive_lms() updates all ``N`` coefficients after every sample, so
+ *  a frame of ``L`` samples costs ``L`` calls and ``L`` loads and stores of
+ *  every coefficient. Here the coefficients are held for the whole frame and
+ *  the update is delayed to its end:
+ *
+ *  \code
+ *  1) For each sample j of the frame:
+ *     output[j] = FIR( input[j] ), error[j] = reference[j] - output[j]
+ *  2) For each tap: FIR_COEFFS[n] = FIR_COEFFS[n] +
+ *     (mu / L) * (error[0] * x[0][n] + ... + error[L-1] * x[L-1][n])
+ *  \endcode
+ *
+ *  where ``x[j]`` is the filter state at sample ``j``. The state array keeps
+ *  the frame, newest sample first, in front of the ``N`` previous samples,
+ *  so the state of every sample of the frame is a contiguous window of it and
+ *  nothing is shifted per sample; step 1 is a block FIR over it. The gradient
+ *  of each tap is accumulated over the frame in 64 bits and rounded once.
+ *
+ *  With ``L`` = 1 the results equal those of dsp_adaptive_lms(). The update
+ *  of a frame is the mean of its ``L`` sample gradients, as ``mu`` is divided
+ *  by ``L`` before it is applied, so convergence can take up to ``L`` times
+ *  as many samples as with dsp_adaptive_lms().
+ *
+ *  Example of a 256-tap LMS filter on frames of 16 samples:
+ *
+ *  \code
+ *  int32_t filter_coeff[256] = { ... not shown for brevity };
+ *  int32_t filter_state[256 + 16] = { 0, 0, 0, 0, ... not shown for brevity };
+ *
+ *  dsp_adaptive_lms_block
+ *  (
+ *    input_frame, reference_frame, error_frame, output_frame,
+ *    filter_coeff, filter_state, 256, 16, Q28(0.001), 28
+ *  );
+ *  \endcode
+ *
+ *  \param  input_samples      The ``L`` new samples to be processed.
+ *  \param  reference_samples  The ``L`` reference samples.
+ *  \param  error_samples      The ``L`` resulting error samples
+ *                             (error = reference - output).
+ *  \param  output_samples     The ``L`` resulting filter output samples.
+ *  \param  filter_coeffs      Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *  \param  state_data         FIR filter state data array of length ``N + L``.
+ *                             Must be initialized at startup to all zeros
+ *                             and used with the same ``L`` on every call.
+ *  \param  num_taps           Filter tap count where N = num_taps = filter order + 1.
+ *  \param  block_length       Frame length ``L``, from 1 to
+ *                             ``DSP_ADAPTIVE_BLOCK_MAX_LENGTH``.
+ *  \param  mu                 Coefficient adjustment step size, controls rate of convergence.
+ *  \param  q_format           Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_adaptive_lms_block
+(
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       error_samples[],
+    int32_t       output_samples[],
+    int32_t       filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t block_length,
+    const int32_t mu,
+    int32_t       q_format
+);
+
+/** This function implements a block normalized LMS adaptive FIR filter on a
+ *  frame of samples.
+ *
+ *  It works as dsp_adaptive_lms_block(), but each error is normalised by the
+ *  energy ``E = x[j][0]^2 + ... + x[j][N-1]^2`` of the state it was measured
+ *  with before it is accumulated into the gradient, as in
+ *  dsp_adaptive_nlms(). The energy is computed once per frame and then kept
+ *  up to date exactly as each sample enters and leaves the window. With
+ *  ``L`` = 1 the results equal those of dsp_adaptive_nlms().
+ *
+ *  \param  input_samples      The ``L`` new samples to be processed.
+ *  \param  reference_samples  The ``L`` reference samples.
+ *  \param  error_samples      The ``L`` resulting error samples
+ *                             (error = reference - output).
+ *  \param  output_samples     The ``L`` resulting filter output samples.
+ *  \param  filter_coeffs      Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *  \param  state_data         FIR filter state data array of length ``N + L``.
+ *                             Must be initialized at startup to all zeros
+ *                             and used with the same ``L`` on every call.
+ *  \param  num_taps           Filter tap count where N = num_taps = filter order + 1.
+ *  \param  block_length       Frame length ``L``, from 1 to
+ *                             ``DSP_ADAPTIVE_BLOCK_MAX_LENGTH``.
+ *  \param  mu                 Coefficient adjustment step size, controls rate of convergence.
+ *  \param  q_format           Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_adaptive_nlms_block
+(
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       error_samples[],
+    int32_t       output_samples[],
+    int32_t       filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t block_length,
+    const int32_t mu,
+    int32_t       q_format
+);
+
+/** Partitioned-block frequency-domain adaptive filter (PBFDAF).
+ *
+ *  Holds the frequency-domain input history, the partitioned filter weights
+ *  and the per-bin input power. Initialise with dsp_adaptive_pbfdaf_init()
+ *  and do not modify the members directly.
+ */
+typedef struct {
+    dsp_complex_t * UNSAFE spectra;        ///< Input spectra, one per partition, newest at ``newest``.
+    dsp_complex_t * UNSAFE weights;        ///< Weight spectra, one per partition.
+    dsp_complex_t * UNSAFE scratch;        ///< Output, error and gradient spectra.
+    uint64_t * UNSAFE      power;          ///< Smoothed input power per bin, DC to Nyquist.
+    int32_t * UNSAFE       history;        ///< Previous block of input samples.
+    const int32_t * UNSAFE sine;           ///< Sine table for a ``block_length`` point FFT.
+    const int32_t * UNSAFE sine2;          ///< Sine table for a 2 * ``block_length`` point FFT.
+    uint64_t               min_power;      ///< Per-bin power regularisation.
+    int32_t                block_length;   ///< Samples per block B.
+    int32_t                num_partitions; ///< Number of partitions P.
+    int32_t                newest;         ///< Partition slot holding the newest spectrum.
+    int32_t                mu;             ///< Step size per partition.
+    int32_t                power_shift;    ///< Power smoothing, forgetting factor 1 - 2^-power_shift.
+    int32_t                constrained;    ///< Non-zero for the constrained gradient.
+    int32_t                q_format;       ///< Fixed point format of the weights and step size.
+} dsp_adaptive_pbfdaf_t;
+
+/** This function initialises a partitioned-block frequency-domain adaptive
+ *  filter and clears its weights and history.
+ *
+ *  The filter has ``block_length`` * ``num_partitions`` taps and processes
+ *  ``block_length`` samples per call, with an FFT of 2 * ``block_length``
+ *  points. The buffers must be double-word aligned. An unsupported
+ *  ``block_length`` or fewer than one partition is rejected and the filter
+ *  is left uninitialised.
+ *
+ *  \param  filter          PBFDAF object.
+ *  \param  block_length    Samples per block B; a power of two from 4 to 8192.
+ *  \param  num_partitions  Number of partitions P.
+ *  \param  spectra         Input spectra array of P * B elements.
+ *  \param  weights         Weights array of P * B elements.
+ *  \param  scratch         Scratch array of 3 * B elements.
+ *  \param  power           Power array of B + 1 elements.
+ *  \param  history         Input history array of B words.
+ *  \param  mu              Step size, in ``q_format``; 0 < mu < 1. It is shared
+ *                          between the partitions, so the same value suits any
+ *                          filter length; 0.5 is a typical starting point.
+ *  \param  power_shift     Smoothing of the per-bin input power; the forgetting
+ *                          factor per block is ``1 - 2^-power_shift``.
+ *  \param  min_level       RMS input level, in sample units, below which the
+ *                          step size is reduced instead of normalised. This
+ *                          regularises the bins where the input has no energy.
+ *  \param  constrained     Non-zero to constrain the gradient to B taps per
+ *                          partition (two more FFTs per partition per block).
+ *  \param  q_format        Fixed point format of the weights and of ``mu``.
+ *                          The weights are unscaled spectra, so a bin can
+ *                          reach the sum of the magnitudes of the ``B`` taps
+ *                          of its partition; leave enough integer bits for
+ *                          that, e.g. Q24 for an echo path of a few hundred
+ *                          taps per partition.
+ *  \returns                0 on success, -1 if the sizes are not supported.
+ */
+
+int32_t dsp_adaptive_pbfdaf_init
+(
+    REFERENCE_PARAM(dsp_adaptive_pbfdaf_t, filter),
+    const int32_t block_length,
+    const int32_t num_partitions,
+    dsp_complex_t spectra[],
+    dsp_complex_t weights[],
+    dsp_complex_t scratch[],
+    uint64_t      power[],
+    int32_t       history[],
+    const int32_t mu,
+    const int32_t power_shift,
+    const int32_t min_level,
+    const int32_t constrained,
+    const int32_t q_format
+);
+
+/** This function implements one block of a partitioned-block
+ *  frequency-domain adaptive filter.
+ *
+ *  This is the frame-based equivalent of dsp_adaptive_nlms() for long
+ *  filters, e.g. echo tails of thousands of taps. The ``B * P`` tap filter is
+ *  split into ``P`` partitions of ``B`` taps, each held as a spectrum of the
+ *  real FFT of size ``2B`` (overlap-save). Per block:
+ *
+ *  \code
+ *  1) X[0] = FFT( previous B inputs, new B inputs ); older spectra move to X[1..P-1]
+ *  2) output = last B samples of IFFT( X[0]*W[0] + ... + X[P-1]*W[P-1] )
+ *  3) error = reference - output
+ *  4) E = FFT( B zeros, error )
+ *  5) Per bin k: power[k] = power[k] * (1 - 2^-s) + |X[0][k]|^2 * 2^-s
+ *  6) G[p] = mu * conj(X[p]) * E / (power + min_level^2/2B)
+ *  7) If constrained, G[p] = FFT( first B samples of IFFT( G[p] ), B zeros )
+ *  8) W[p] = W[p] + G[p]
+ *  \endcode
+ *
+ *  Steps 2 and 6 use dsp_complex_macc_vector() and
+ *  dsp_complex_mul_conjugate_vector3(). Normalising each bin by its own input
+ *  power decorrelates coloured input such as speech, so the filter converges
+ *  much faster than a time-domain NLMS of the same length. The cost per block
+ *  is three real FFTs plus 3 complex multiply-accumulates per bin per
+ *  partition, i.e. a small multiple of one FFT per block, and ``2P`` further
+ *  FFTs if the gradient is constrained. The unconstrained filter is cheaper
+ *  but converges to a slightly biased solution; the constrained filter matches
+ *  block NLMS. The output is delayed by one block relative to a time-domain
+ *  filter, as the whole block of input is needed before any output is
+ *  produced.
+ *
+ *  \param  filter             PBFDAF object.
+ *  \param  input_samples      The ``B`` new input samples, oldest first.
+ *  \param  reference_samples  The ``B`` reference samples, oldest first.
+ *  \param  output_samples     The ``B`` resulting filter output samples.
+ *  \param  error_samples      The ``B`` resulting error samples
+ *                             (error = reference - output).
+ */
+
+void dsp_adaptive_pbfdaf
+(
+    REFERENCE_PARAM(dsp_adaptive_pbfdaf_t, filter),
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       output_samples[],
+    int32_t       error_samples[]
+);
+
+/** Subband adaptive filter.
+ *
+ *  Holds the subband input history, the per-band complex filter weights and
+ *  the per-band input energy. Initialise with dsp_adaptive_subband_init()
+ *  and do not modify the members directly.
+ */
+typedef struct {
+    dsp_filterbank_t * UNSAFE input_bank;     ///< Analysis filterbank of the input.
+    dsp_filterbank_t * UNSAFE reference_bank; ///< Analysis filterbank of the reference, synthesis of the error.
+    dsp_complex_t * UNSAFE    spectra;        ///< Subband input frames, one per tap, newest at ``newest``.
+    dsp_complex_t * UNSAFE    weights;        ///< Subband weight frames, one per tap.
+    dsp_complex_t * UNSAFE    scratch;        ///< Output, error and gradient frames.
+    uint64_t * UNSAFE         power;          ///< Input energy over the taps of each band, DC to Nyquist.
+    uint64_t                  min_power;      ///< Per-band energy regularisation.
+    int32_t                   num_bins;       ///< Subband frame size, ``num_bands`` / 2.
+    int32_t                   num_taps;       ///< Taps per subband filter.
+    int32_t                   newest;         ///< Frame slot holding the newest input frame.
+    int32_t                   mu;             ///< Step size.
+    int32_t                   q_format;       ///< Fixed point format of the weights and step size.
+} dsp_adaptive_subband_t;
+
+/** This function initialises a subband adaptive filter and clears its
+ *  weights and history.
+ *
+ *  The two filterbanks must have been initialised by dsp_filterbank_init()
+ *  with the same prototype, ``num_bands`` and ``hop``. The input filterbank
+ *  only analyses, the reference filterbank analyses the reference and
+ *  synthesises the error. The buffers must be double-word aligned.
+ *
+ *  \param  filter          Subband adaptive filter object.
+ *  \param  input_bank      Filterbank for the input signal.
+ *  \param  reference_bank  Filterbank for the reference and error signals.
+ *  \param  num_taps        Taps per subband filter L. An echo tail of T
+ *                          samples needs about T / ``hop`` + ``length`` /
+ *                          ``hop`` taps.
+ *  \param  spectra         Input frames array of L * ``num_bands`` / 2 elements.
+ *  \param  weights         Weights array of L * ``num_bands`` / 2 elements.
+ *  \param  scratch         Scratch array of 3 * ``num_bands`` / 2 elements.
+ *  \param  power           Energy array of ``num_bands`` / 2 + 1 elements.
+ *  \param  mu              Step size, in ``q_format``; 0 < mu < 1.
+ *  \param  min_level       RMS input level, in sample units, below which the
+ *                          step size is reduced instead of normalised. This
+ *                          regularises the bands where the input has no
+ *                          energy.
+ *  \param  q_format        Fixed point format of the weights and of ``mu``.
+ */
+
+void dsp_adaptive_subband_init
+(
+    REFERENCE_PARAM(dsp_adaptive_subband_t, filter),
+    REFERENCE_PARAM(dsp_filterbank_t, input_bank),
+    REFERENCE_PARAM(dsp_filterbank_t, reference_bank),
+    const int32_t num_taps,
+    dsp_complex_t spectra[],
+    dsp_complex_t weights[],
+    dsp_complex_t scratch[],
+    uint64_t      power[],
+    const int32_t mu,
+    const int32_t min_level,
+    const int32_t q_format
+);
+
+/** This function implements one hop of a subband adaptive filter.
+ *
+ *  The input and reference are each split by an oversampled filterbank (see
+ *  dsp_filterbank_analyse()) into ``num_bands`` / 2 + 1 subbands decimated
+ *  by ``hop``. Each subband runs its own complex NLMS filter of L taps at the
+ *  decimated rate, and the subband errors are synthesised back into a full
+ *  band error signal. Per hop, with X[k] the input frame of ``k`` hops ago:
+ *
+ *  \code
+ *  1) X[0] = analyse( input ); D = analyse( reference )
+ *  2) Y = W[0]*X[0] + W[1]*X[1] + ... + W[L-1]*X[L-1]
+ *  3) E = D - Y
+ *  4) Per band b: P[b] = |X[0][b]|^2 + ... + |X[L-1][b]|^2
+ *  5) W[k] = W[k] + mu * conj(X[k]) * E / (P + min_power)
+ *  6) error = synthesise( E )
+ *  \endcode
+ *
+ *  Steps 2 and 5 process all bands at once for each tap with
+ *  dsp_complex_macc_vector() and dsp_complex_mul_conjugate_vector3(). The
+ *  energy of step 4 is updated exactly from the frame that enters and the
+ *  frame that leaves, so it costs one pass over the bands per hop.
+ *
+ *  A tail of T samples needs about T / ``hop`` taps per band. The cost per
+ *  input sample is then roughly 3 * (``num_bands`` / 2) * L / ``hop``
+ *  complex multiply-accumulates, plus three FFTs of ``num_bands`` points and
+ *  three prototype windows of ``length`` taps per hop. For a tail of 4096
+ *  samples with 64 bands and a hop of 32, that is about 400 real
+ *  multiply-accumulates per sample against about 12000 for
+ *  dsp_adaptive_nlms(). The bands are also whitened separately, so the filter
+ *  converges much faster than a full band NLMS on coloured input such as
+ *  speech. The error is delayed by ``length`` - ``hop`` samples relative to the
+ *  reference. The attenuation is limited by the aliasing between subbands:
+ *  about 30 dB with a hop of ``num_bands`` / 2 and 35 dB with a hop of
+ *  ``num_bands`` / 4.
+ *
+ *  \param  filter             Subband adaptive filter object.
+ *  \param  input_samples      The ``hop`` new input samples, oldest first.
+ *  \param  reference_samples  The ``hop`` reference samples, oldest first.
+ *  \param  error_samples      The ``hop`` resulting error samples.
+ */
+
+void dsp_adaptive_subband
+(
+    REFERENCE_PARAM(dsp_adaptive_subband_t, filter),
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       error_samples[]
+);
+
+/** Recursive least-squares (RLS) adaptive filter.
+ *
+ *  Holds a square root of the inverse input correlation matrix P of an RLS
+ *  filter in block floating point. Initialise with dsp_adaptive_rls_init()
+ *  and do not modify the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE sqrt_p;              ///< N x N matrix T with P = T^T T, row-major.
+    int64_t * UNSAFE products;            ///< N 64-bit products T x.
+    int32_t * UNSAFE scratch;             ///< Two vectors of N words.
+    int32_t          num_taps;            ///< Filter tap count N.
+    int32_t          lambda;              ///< Forgetting factor in Q30.
+    uint32_t         inverse_sqrt_lambda; ///< 1 / sqrt(lambda) in Q30.
+    uint32_t         scale;               ///< Mantissa of the scale of ``sqrt_p``, in [1,2) in Q30.
+    int32_t          exponent;            ///< Exponent of the scale of ``sqrt_p``.
+    int32_t          count;               ///< Samples since ``sqrt_p`` was last renormalised.
+    int32_t          q_format;            ///< Fixed point format of the samples and coefficients.
+} dsp_adaptive_rls_t;
+
+/** This function initialises an RLS adaptive filter with P = I / ``delta``.
+ *
+ *  \param  rls        RLS object.
+ *  \param  num_taps   Filter tap count N; even, from 2 to 64.
+ *  \param  sqrt_p     Array of N * N words for the square root of P; must be
+ *                     double-word aligned.
+ *  \param  products   Array of N 64-bit words for the products T x.
+ *  \param  scratch    Array of 2 * N words; must be double-word aligned.
+ *  \param  lambda     Forgetting factor in Q30, typically 0.99 to 0.9999 (the
+ *                     filter remembers about 1 / (1 - lambda) samples).
+ *  \param  delta      Regularisation, in ``q_format``; a positive value of
+ *                     the order of the input power. Smaller values give
+ *                     faster initial convergence.
+ *  \param  q_format   Fixed point format of the samples and coefficients.
+ */
+
+void dsp_adaptive_rls_init
+(
+    REFERENCE_PARAM(dsp_adaptive_rls_t, rls),
+    const int32_t num_taps,
+    int32_t       sqrt_p[],
+    int64_t       products[],
+    int32_t       scratch[],
+    const int32_t lambda,
+    const int32_t delta,
+    const int32_t q_format
+);
+
+/** This function implements a recursive least-squares adaptive FIR filter.
+ *
+ *  RLS minimises the exponentially weighted sum of squared errors exactly at
+ *  every sample, so it converges in a few times N samples regardless of the
+ *  colour of the input, where LMS and NLMS can take orders of magnitude
+ *  longer. This suits short filters that must track quickly, such as
+ *  equalisers. It uses the square-root (Potter) form, which updates a square
+ *  root T of the inverse correlation matrix P = T^T T so that P stays
+ *  symmetric and positive definite in fixed point. Per sample:
+ *
+ *  \code
+ *  1) output = FIR( input ), error = reference - output
+ *  2) f = T x, alpha = lambda + |f|^2
+ *  3) v = T^T f / |f|, the gain vector P x / alpha up to a scalar
+ *  4) FIR_COEFFS = FIR_COEFFS + v * error * |f| / alpha
+ *  5) T = ( T - |f| * f v^T / (alpha + sqrt(lambda * alpha)) ) / sqrt(lambda)
+ *  \endcode
+ *
+ *  T is held as 32-bit entries with a shared scale. The 1 / sqrt(lambda) of
+ *  step 5 only changes the scale, and the entries are renormalised once every
+ *  N samples, so T keeps its precision however P evolves. Steps 2 and 3 are
+ *  matrix-vector products accumulated in 64 bits, step 4 adds a scaled copy
+ *  of v and step 5 is a rank-one update made of N calls to
+ *  dsp_vector_muls_addv(), one per row. The scalars need two 64-bit square
+ *  roots and three divisions per sample.
+ *
+ *  The cost is about 3 * N^2 multiply-accumulates per sample. The thread
+ *  cycles per sample below are estimated from the instruction counts of the
+ *  inner loops (roughly 15 * N^2 + 1000 instructions), not measured:
+ *
+ *  \code
+ *  taps               8     16     32     64
+ *  estimated cycles   2000  5000   16000  62000
+ *  \endcode
+ *
+ *  \param  input_sample      The new sample to be processed.
+ *  \param  reference_sample  Reference sample.
+ *  \param  error_sample      Pointer to resulting error sample (error = reference - output)
+ *  \param  filter_coeffs     Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *                            Must be double-word aligned.
+ *  \param  state_data        Pointer to FIR filter state data array of length N.
+ *                            Must be initialized at startup to all zeros.
+ *  \param  rls               RLS object for this filter.
+ *  \returns                  The resulting filter output sample.
+ */
+
+int32_t dsp_adaptive_rls
+(
+    int32_t input_sample,
+    int32_t reference_sample,
+    int32_t *error_sample,
+    const int32_t filter_coeffs[],
+    int32_t state_data[],
+    REFERENCE_PARAM(dsp_adaptive_rls_t, rls)
+);
+
+#define DSP_ADAPTIVE_APA_MAX_ORDER 8  // Largest projection order of dsp_adaptive_apa()
+
+/** Affine projection adaptive filter.
+ *
+ *  Holds the input history of each projection, the recent reference samples
+ *  and the recursively updated input correlation. Initialise with
+ *  dsp_adaptive_apa_init() and do not modify the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE state_data; ///< Input history of N + K - 1 words from x[n]; state p starts at word p.
+    int64_t correlation[DSP_ADAPTIVE_APA_MAX_ORDER][DSP_ADAPTIVE_APA_MAX_ORDER]; ///< Ring of correlation rows, row ``newest`` at lags 0 to ``order``-1.
+    int32_t reference[DSP_ADAPTIVE_APA_MAX_ORDER];  ///< Ring of reference samples, d[n] at ``newest``.
+    int64_t delta;               ///< Regularisation in correlation units.
+    int32_t num_taps;            ///< Filter tap count N.
+    int32_t order;               ///< Projection order K.
+    int32_t newest;              ///< Ring slot of the newest row and reference.
+    int32_t mu;                  ///< Step size.
+    int32_t q_format;            ///< Fixed point format of the samples, coefficients and step size.
+} dsp_adaptive_apa_t;
+
+/** This function initialises an affine projection adaptive filter and
+ *  clears its history.
+ *
+ *  \param  apa         APA object.
+ *  \param  num_taps    Filter tap count N.
+ *  \param  order       Projection order K, from 1 to ``DSP_ADAPTIVE_APA_MAX_ORDER``.
+ *                      Order 1 is NLMS; 2 to 8 are typical for speech.
+ *  \param  state_data  Array of N + K - 1 words for the input history.
+ *  \param  mu          Step size, in ``q_format``; 0 < mu <= 1.
+ *  \param  delta       Regularisation added to the diagonal of the input
+ *                      correlation, in ``q_format``; e.g. N times a small
+ *                      fraction of the expected input power.
+ *  \param  q_format    Fixed point format of the samples, coefficients and
+ *                      ``mu``.
+ */
+
+void dsp_adaptive_apa_init
+(
+    REFERENCE_PARAM(dsp_adaptive_apa_t, apa),
+    const int32_t num_taps,
+    const int32_t order,
+    int32_t       state_data[],
+    const int32_t mu,
+    const int32_t delta,
+    const int32_t q_format
+);
+
+/** This function implements an affine projection (APA) adaptive FIR filter.
+ *
+ *  NLMS projects the error onto the newest input vector only, so strongly
+ *  coloured input such as speech makes it converge slowly. APA of order K
+ *  projects onto the last K input vectors at once, which whitens the input
+ *  over K samples and converges several times faster for a cost of about K
+ *  times that of NLMS. Per sample, with X = [ x[n], x[n-1], ..., x[n-K+1] ]
+ *  the N x K matrix of the last K state vectors:
+ *
+ *  \code
+ *  1) output = FIR( input ), e[p] = reference[n-p] - x[n-p]^T b, p = 0..K-1
+ *  2) R = X^T X + delta I, updated recursively
+ *  3) Solve R a = e
+ *  4) FIR_COEFFS = FIR_COEFFS + mu * X a
+ *  \endcode
+ *
+ *  The K state vectors overlap, so they are held as one history of
+ *  N + K - 1 samples that is shifted once per sample. Step 1 is K dot
+ *  products over that history, and step 4 applies all K vectors to each
+ *  coefficient in a single pass, for 2 * K * N multiply-accumulates per
+ *  sample. X^T X is a sliding window correlation: row i is the first row from
+ *  i samples ago, and the new first row is updated from the samples entering
+ *  and leaving the window in O(K) operations. It is accumulated in 64 bits
+ *  with 8 bits dropped from each product, and every product leaves the sum
+ *  exactly as it entered it, so it does not drift. Step 3 factorises
+ *  R = L D L^T in fixed point instead of inverting it, in about K^3 / 6
+ *  multiplications and K divisions. Pivots below 2^-10 of the largest
+ *  diagonal are raised to that level, which adds regularisation when the
+ *  input is very strongly correlated.
+ *
+ *  \param  input_sample      The new sample to be processed.
+ *  \param  reference_sample  Reference sample.
+ *  \param  error_sample      Pointer to resulting error sample (error = reference - output)
+ *  \param  filter_coeffs     Pointer to FIR coefficients arranged as [b0,b1,b2, ...,bN-1].
+ *                            Must be double-word aligned.
+ *  \param  apa               APA object for this filter.
+ *  \returns                  The resulting filter output sample.
+ */
+
+int32_t dsp_adaptive_apa
+(
+    int32_t input_sample,
+    int32_t reference_sample,
+    int32_t *error_sample,
+    const int32_t filter_coeffs[],
+    REFERENCE_PARAM(dsp_adaptive_apa_t, apa)
+);
+
 #ifdef __XC__
 }
 #endif
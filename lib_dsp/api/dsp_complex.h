@@ -4,6 +4,17 @@
 #define DSP_COMPLEX_H_
 
 #include <stdint.h>
+#include "xccompat.h"
+
+// Qualifier for pointers in structures shared between C and XC, used by
+// the other lib_dsp headers through this one
+#ifndef UNSAFE
+#ifdef __XC__
+#define UNSAFE unsafe
+#else
+#define UNSAFE
+#endif //__XC__
+#endif
 
 /** Type that represents a complex number. Both the real and imaginary
  * parts are represented as 32-bit fixed point values, with a Q value that
@@ -120,7 +131,7 @@ dsp_complex_t dsp_complex_mul_conjugate(dsp_complex_t a, dsp_complex_t b, uint32
  *
  * \returns       inner product - it may overflow.
  */
-dsp_complex_t dsp_complex_fir(dsp_complex_t a[], dsp_complex_t b[],
+dsp_complex_t dsp_complex_fir(dsp_complex_t a[], const dsp_complex_t b[],
                               uint32_t N, uint32_t offset, uint32_t Q);
 
 /** Function that computes the element-by-element product of two complex
@@ -393,4 +404,113 @@ void dsp_complex_split (const dsp_complex_t complex[],
                         int32_t re[],
                         int32_t im[],
                         const uint32_t N);
+
+/** Streaming complex FIR filter.
+ *
+ * Holds the input history of a complex FIR filter as a mirrored circular
+ * buffer, so that the most recent samples are always contiguous in memory.
+ * Initialise with dsp_complex_fir_init() and do not modify the members
+ * directly. The coefficients are passed on each call, so one set may be
+ * shared between many filters.
+ */
+typedef struct {
+    dsp_complex_t * UNSAFE state; ///< Mirrored history, newest at state[index].
+    uint32_t num_taps;            ///< Number of filter taps N.
+    uint32_t index;               ///< Position of the newest sample.
+} dsp_complex_fir_t;
+
+/** Function that initialises a streaming complex FIR filter and clears its
+ * history.
+ *
+ * \param[out] fir       Complex FIR filter object
+ * \param[in]  state     State array of 2 * (``num_taps`` + 1) elements
+ * \param[in]  num_taps  Number of filter taps N
+ */
+void dsp_complex_fir_init(REFERENCE_PARAM(dsp_complex_fir_t, fir),
+                          dsp_complex_t state[],
+                          const uint32_t num_taps);
+
+/** Function that pushes one complex sample into a streaming complex FIR
+ * filter and computes one output sample:
+ *
+ *   y[n] = b[0] * x[n] + b[1] * x[n-1] + ... + b[N-1] * x[n-N+1]
+ *
+ * The inner product is computed by dsp_complex_fir() directly on the
+ * history buffer, so the result is identical: 64-bit accumulation, shifted
+ * down by Q bits without rounding or saturation.
+ *
+ * \param[in,out] fir           Complex FIR filter object
+ * \param[in]     input_sample  New complex input sample
+ * \param[in]     coeffs        Complex coefficients ``b[0]..b[N-1]``
+ * \param[in]     Q             Number of bits behind the binary point in the
+ *                              coefficients
+ *
+ * \returns       filter output - it may overflow.
+ */
+dsp_complex_t dsp_complex_fir_process(REFERENCE_PARAM(dsp_complex_fir_t, fir),
+                                      dsp_complex_t input_sample,
+                                      const dsp_complex_t coeffs[],
+                                      const uint32_t Q);
+
+/** Function that filters a block of complex samples with a streaming complex
+ * FIR filter. The results are identical to calling dsp_complex_fir_process()
+ * on each sample in turn.
+ *
+ * Outputs are computed two at a time. Consecutive outputs use windows of
+ * the history that differ by one sample, so each coefficient and each
+ * history sample is loaded once and used for both outputs, halving the
+ * memory traffic per output.
+ *
+ * \param[in,out] fir             Complex FIR filter object
+ * \param[in]     input_samples   Block of complex input samples, oldest first
+ * \param[out]    output_samples  Block of complex output samples
+ * \param[in]     num_samples     Number of samples in the block
+ * \param[in]     coeffs          Complex coefficients ``b[0]..b[N-1]``
+ * \param[in]     Q               Number of bits behind the binary point in the
+ *                                coefficients
+ */
+void dsp_complex_fir_process_block(REFERENCE_PARAM(dsp_complex_fir_t, fir),
+                                   const dsp_complex_t input_samples[],
+                                   dsp_complex_t output_samples[],
+                                   const uint32_t num_samples,
+                                   const dsp_complex_t coeffs[],
+                                   const uint32_t Q);
+
+/** Function that pushes one complex sample into a streaming complex FIR
+ * filter with real coefficients and computes one output sample. Filtering
+ * complex data with real coefficients needs two multiplies per tap rather
+ * than four.
+ *
+ * \param[in,out] fir           Complex FIR filter object
+ * \param[in]     input_sample  New complex input sample
+ * \param[in]     coeffs        Real coefficients ``b[0]..b[N-1]``
+ * \param[in]     Q             Number of bits behind the binary point in the
+ *                              coefficients
+ *
+ * \returns       filter output - it may overflow.
+ */
+dsp_complex_t dsp_complex_fir_process_real(REFERENCE_PARAM(dsp_complex_fir_t, fir),
+                                           dsp_complex_t input_sample,
+                                           const int32_t coeffs[],
+                                           const uint32_t Q);
+
+/** Function that filters a block of complex samples with a streaming complex
+ * FIR filter with real coefficients, two outputs at a time as in
+ * dsp_complex_fir_process_block(). The results are identical to calling
+ * dsp_complex_fir_process_real() on each sample in turn.
+ *
+ * \param[in,out] fir             Complex FIR filter object
+ * \param[in]     input_samples   Block of complex input samples, oldest first
+ * \param[out]    output_samples  Block of complex output samples
+ * \param[in]     num_samples     Number of samples in the block
+ * \param[in]     coeffs          Real coefficients ``b[0]..b[N-1]``
+ * \param[in]     Q               Number of bits behind the binary point in the
+ *                                coefficients
+ */
+void dsp_complex_fir_process_real_block(REFERENCE_PARAM(dsp_complex_fir_t, fir),
+                                        const dsp_complex_t input_samples[],
+                                        dsp_complex_t output_samples[],
+                                        const uint32_t num_samples,
+                                        const int32_t coeffs[],
+                                        const uint32_t Q);
 #endif
@@ -0,0 +1,174 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+
+#ifndef DSP_DELAY_H_
+#define DSP_DELAY_H_
+
+#include "stdint.h"
+#include "xccompat.h"
+#include "dsp_complex.h"
+
+#define DSP_DELAY_LINE_FRAC_BITS 16  // Fractional bits of a delay, in samples
+
+/** Delay line.
+ *
+ *  A circular buffer of recent input samples whose length is a power of two,
+ *  so wrap-around is a single mask. Any number of taps at integer or
+ *  fractional delays can be read from the same buffer without copying.
+ *  Initialise with dsp_delay_line_init() and do not modify the members
+ *  directly.
+ */
+typedef struct {
+    int32_t * UNSAFE buffer;      ///< Circular sample buffer.
+    uint32_t         mask;        ///< Buffer length minus one.
+    uint32_t         write_index; ///< Slot for the next sample written.
+} dsp_delay_line_t;
+
+/** This function initialises a delay line and clears its buffer.
+ *
+ *  \param  delay_line  Delay line object.
+ *  \param  buffer      Sample buffer of ``length`` words.
+ *  \param  length      Buffer length; must be a power of two. The longest
+ *                      readable delay is ``length`` - 1 samples, less the
+ *                      extra samples used by the interpolating reads.
+ */
+
+void dsp_delay_line_init
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    int32_t       buffer[],
+    const int32_t length
+);
+
+/** This function writes one sample into a delay line.
+ *
+ *  \param  delay_line  Delay line object.
+ *  \param  sample      The new sample; it becomes delay 0.
+ */
+
+void dsp_delay_line_write
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    int32_t sample
+);
+
+/** This function writes a block of samples into a delay line.
+ *
+ *  The samples are written oldest first, so after the call
+ *  ``samples[num_samples-1]`` is at delay 0. To read taps relative to sample
+ *  ``i`` of the block, add ``num_samples - 1 - i`` samples to each delay.
+ *
+ *  \param  delay_line   Delay line object.
+ *  \param  samples      The block of new samples, oldest first.
+ *  \param  num_samples  Number of samples in the block; at most the buffer length.
+ */
+
+void dsp_delay_line_write_block
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    const int32_t samples[],
+    const int32_t num_samples
+);
+
+/** This function reads taps at integer delays from a delay line.
+ *
+ *  \param  delay_line  Delay line object.
+ *  \param  delays      Delay of each tap in samples (0 is the newest sample).
+ *  \param  outputs     The sample read for each tap.
+ *  \param  num_taps    Number of taps.
+ */
+
+void dsp_delay_line_read
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    const uint32_t delays[],
+    int32_t        outputs[],
+    const int32_t  num_taps
+);
+
+/** This function reads taps at fractional delays using linear interpolation.
+ *
+ *  Each delay is an unsigned fixed-point number of samples with
+ *  ``DSP_DELAY_LINE_FRAC_BITS`` fractional bits. A tap at delay ``D + f``
+ *  (integer ``D``, fraction ``0 <= f < 1``) returns
+ *  ``x[n-D] * (1-f) + x[n-D-1] * f``, computed with a 64-bit accumulator and
+ *  rounded. The delay may range from 0 to ``length`` - 2 samples.
+ *
+ *  \param  delay_line  Delay line object.
+ *  \param  delays      Delay of each tap, with ``DSP_DELAY_LINE_FRAC_BITS``
+ *                      fractional bits.
+ *  \param  outputs     The interpolated sample for each tap.
+ *  \param  num_taps    Number of taps.
+ */
+
+void dsp_delay_line_read_linear
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    const uint32_t delays[],
+    int32_t        outputs[],
+    const int32_t  num_taps
+);
+
+/** This function reads taps at fractional delays using cubic Lagrange
+ *  interpolation.
+ *
+ *  A tap at delay ``D + f`` fits a cubic through the samples at delays
+ *  ``D-1``, ``D``, ``D+1`` and ``D+2`` and evaluates it at ``D + f``. The four
+ *  Lagrange weights are computed from ``f`` in Q30 and applied with a 64-bit
+ *  accumulator. The delay may range from 1 to ``length`` - 3 samples. Cubic
+ *  interpolation has a much flatter frequency response and lower aliasing
+ *  than linear interpolation for modulated delays such as chorus.
+ *
+ *  \param  delay_line  Delay line object.
+ *  \param  delays      Delay of each tap, with ``DSP_DELAY_LINE_FRAC_BITS``
+ *                      fractional bits.
+ *  \param  outputs     The interpolated sample for each tap.
+ *  \param  num_taps    Number of taps.
+ */
+
+void dsp_delay_line_read_cubic
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    const uint32_t delays[],
+    int32_t        outputs[],
+    const int32_t  num_taps
+);
+
+/** This function reads taps at fractional delays using a polyphase bank of
+ *  short fractional-delay FIR filters.
+ *
+ *  ``filter_coeffs`` holds ``num_phases`` sub-filters of ``phase_length`` taps
+ *  each, sub-filter ``p`` occupying ``filter_coeffs[p*phase_length]`` onwards.
+ *  Sub-filter ``p`` must delay by ``phase_length/2 - 1 + p/num_phases`` samples,
+ *  e.g. a windowed sinc sampled at those offsets. A tap at delay ``D + f``
+ *  uses the sub-filter nearest to ``f`` and the ``phase_length`` samples from
+ *  delay ``D - phase_length/2 + 1`` onwards, so the delay may range from
+ *  ``phase_length/2 - 1`` to ``length - phase_length/2 - 1`` samples.
+ *
+ *  Products are accumulated in a 64-bit accumulator, saturated and shifted
+ *  right by ``q_format`` bits as in dsp_filters_fir().
+ *
+ *  \param  delay_line     Delay line object.
+ *  \param  delays         Delay of each tap, with ``DSP_DELAY_LINE_FRAC_BITS``
+ *                         fractional bits.
+ *  \param  outputs        The interpolated sample for each tap.
+ *  \param  num_taps       Number of taps.
+ *  \param  filter_coeffs  Polyphase fractional-delay coefficients.
+ *  \param  num_phases     Number of sub-filters.
+ *  \param  phase_length   Taps per sub-filter; must be even.
+ *  \param  q_format       Fixed point format of the coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_delay_line_read_polyphase
+(
+    REFERENCE_PARAM(dsp_delay_line_t, delay_line),
+    const uint32_t delays[],
+    int32_t        outputs[],
+    const int32_t  num_taps,
+    const int32_t  filter_coeffs[],
+    const int32_t  num_phases,
+    const int32_t  phase_length,
+    const int32_t  q_format
+);
+
+#endif
@@ -251,4 +251,87 @@ void dsp_design_biquad_highshelf
     const int32_t q_format
 );
 
+/** This function generates FIR filter coefficients that compensate the
+ *  passband droop of a CIC decimator.
+ *
+ *  The frequency response of an order ``N``, ratio ``R`` CIC decimator,
+ *  normalized to its output sample rate, is
+ *  ``H(f) = (sin(pi*f) / (R*sin(pi*f/R)))^N``. The compensator is a linear
+ *  phase FIR, running at the CIC output rate, whose response is ``1/H(f)``
+ *  across the passband, tapering to zero between ``passband`` and the
+ *  Nyquist frequency. The coefficients also include the factor that corrects
+ *  the DC gain left by dsp_filters_cic_decimate(), so that the combined
+ *  DC gain is 1.0. It is designed by frequency sampling with a Blackman window.
+ *
+ *  Example showing the coefficients of a 32-tap compensator for a 4th order,
+ *  64:1 CIC decimator with a passband edge at 0.4 of the output rate:
+ *
+ *  \code
+ *  int32_t coeffs[32];
+ *  dsp_design_cic_compensator( 4, 64, 0.4, coeffs, 32, 30 );
+ *  \endcode
+ *
+ *  \param  cic_order          Number of CIC integrator and comb stages ``N``.
+ *  \param  cic_decim_factor   CIC decimation ratio ``R``.
+ *  \param  passband           Passband edge normalized to the CIC output
+ *                             sampling frequency, ``0 < passband < 0.5``.
+ *  \param  filter_coeffs      The array used to contain the resulting filter
+ *                             coefficients, ordered as ``[b0,b1,...,bN-1]``.
+ *  \param  num_taps           Number of filter taps.
+ *  \param  q_format           Fixed point format of coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_design_cic_compensator
+(
+    const int32_t cic_order,
+    const int32_t cic_decim_factor,
+    double        passband,
+    int32_t       filter_coeffs[],
+    const int32_t num_taps,
+    const int32_t q_format
+);
+
+/** This function generates the prototype filter of an oversampled polyphase
+ *  DFT filterbank (see dsp_filterbank_init()).
+ *
+ *  The prototype is a root-raised-cosine low-pass filter with a symbol
+ *  period of ``num_bands`` samples, centred in ``length`` taps with a cosine
+ *  taper over the outer quarter at each end. Because its square is a Nyquist
+ *  filter, the time-domain aliasing introduced by folding the window into
+ *  ``num_bands`` samples cancels between analysis and synthesis, up to the
+ *  error caused by truncating the prototype: the reconstruction error is
+ *  roughly -40 dB for a length of four times ``num_bands`` and -50 dB for
+ *  eight times. The roll-off factor is ``0.75 * (num_bands/hop - 1)``,
+ *  limited to the range 0.1 to 1.0, which keeps each subband inside the band
+ *  that survives decimation by ``hop``. The coefficients are scaled so that
+ *  analysis followed by synthesis has unity gain.
+ *
+ *  Example showing the prototype of a 64-band, 2x oversampled filterbank with a
+ *  window of four FFT frames:
+ *
+ *  \code
+ *  int32_t prototype[256];
+ *  dsp_design_filterbank_prototype( 64, 32, prototype, 256, 30 );
+ *  \endcode
+ *
+ *  \param  num_bands      FFT size of the filterbank.
+ *  \param  hop            Hop size of the filterbank.
+ *  \param  filter_coeffs  The array used to contain the resulting prototype
+ *                         coefficients.
+ *  \param  length         Number of prototype taps; a multiple of ``num_bands``.
+ *                         Four to eight times ``num_bands`` gives good
+ *                         reconstruction.
+ *  \param  q_format       Fixed point format of coefficients (i.e. number of fractional bits).
+ *                         The largest tap is below 1.1, so Q30 always fits.
+ */
+
+void dsp_design_filterbank_prototype
+(
+    const int32_t num_bands,
+    const int32_t hop,
+    int32_t       filter_coeffs[],
+    const int32_t length,
+    const int32_t q_format
+);
+
 #endif
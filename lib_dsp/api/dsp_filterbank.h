@@ -0,0 +1,115 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+
+#ifndef DSP_FILTERBANK_H_
+#define DSP_FILTERBANK_H_
+
+#include "stdint.h"
+#include "xccompat.h"
+#include "dsp_complex.h"
+
+/** Oversampled polyphase DFT filterbank.
+ *
+ *  Splits a real signal into ``num_bands`` / 2 + 1 complex subbands, each
+ *  decimated by the hop size, and reconstructs the signal from (possibly
+ *  modified) subbands. Initialise with dsp_filterbank_init() and do not
+ *  modify the members directly.
+ */
+typedef struct {
+    const int32_t * UNSAFE prototype; ///< Prototype low-pass filter, ``length`` taps.
+    int32_t * UNSAFE history;         ///< Analysis input history, oldest first.
+    int32_t * UNSAFE overlap;         ///< Synthesis overlap-add accumulator.
+    const int32_t * UNSAFE sine;      ///< Sine table for a ``num_bands``/2 point FFT.
+    const int32_t * UNSAFE sine2;     ///< Sine table for a ``num_bands`` point FFT.
+    int32_t num_bands;                ///< FFT size K.
+    int32_t hop;                      ///< Input samples per frame R.
+    int32_t length;                   ///< Prototype length L, a multiple of K.
+    int32_t q_format;                 ///< Fixed point format of the prototype.
+} dsp_filterbank_t;
+
+/** This function initialises a polyphase DFT filterbank and clears its
+ *  history.
+ *
+ *  The oversampling factor is ``num_bands`` / ``hop``; a factor of at least
+ *  two keeps the aliasing between adjacent subbands low enough that each
+ *  subband can be scaled or filtered independently, and a critically
+ *  sampled filterbank (``hop`` equal to ``num_bands``) does not reconstruct
+ *  well. Design the prototype with dsp_design_filterbank_prototype() for the
+ *  same ``num_bands``, ``hop`` and ``length``.
+ *
+ *  An unsupported ``num_bands``, or a ``hop`` or ``length`` that does not
+ *  fit it, is rejected and the filterbank is left uninitialised.
+ *
+ *  \param  filterbank  Filterbank object.
+ *  \param  prototype   Prototype filter coefficients, shared by analysis and
+ *                      synthesis.
+ *  \param  length      Number of prototype taps L; a multiple of ``num_bands``.
+ *  \param  num_bands   FFT size K; a power of two from 8 to 16384.
+ *  \param  hop         Samples per frame R; must divide ``num_bands``.
+ *  \param  history     Analysis history array of ``length`` words.
+ *  \param  overlap     Synthesis overlap array of ``length`` words.
+ *  \param  q_format    Fixed point format of the prototype coefficients.
+ *  \returns            0 on success, -1 if the sizes are not supported.
+ */
+
+int32_t dsp_filterbank_init
+(
+    REFERENCE_PARAM(dsp_filterbank_t, filterbank),
+    const int32_t prototype[],
+    const int32_t length,
+    const int32_t num_bands,
+    const int32_t hop,
+    int32_t       history[],
+    int32_t       overlap[],
+    const int32_t q_format
+);
+
+/** This function runs one analysis frame of a polyphase DFT filterbank.
+ *
+ *  The ``hop`` new samples are appended to the last ``length`` samples of
+ *  input, which are weighted by the prototype and folded (time-aliased) into
+ *  ``num_bands`` samples with one 64-bit multiply-accumulate per prototype tap.
+ *  A single real FFT of size ``num_bands`` then produces all subbands, so the
+ *  cost per frame is ``length`` multiply-accumulates plus one FFT, regardless
+ *  of the number of bands.
+ *
+ *  The output uses the packed format of dsp_fft_bit_reverse_and_forward_real():
+ *  ``spectrum[k]`` is subband ``k`` for ``k = 1..num_bands/2-1``,
+ *  ``spectrum[0].re`` is the DC subband and ``spectrum[0].im`` the Nyquist
+ *  subband. The phase of each subband is referenced to the start of the frame.
+ *
+ *  \param  filterbank  Filterbank object.
+ *  \param  input       The ``hop`` new input samples, oldest first.
+ *  \param  spectrum    The subband samples, ``num_bands`` / 2 elements; must be
+ *                      double-word aligned.
+ */
+
+void dsp_filterbank_analyse
+(
+    REFERENCE_PARAM(dsp_filterbank_t, filterbank),
+    const int32_t input[],
+    dsp_complex_t spectrum[]
+);
+
+/** This function runs one synthesis frame of a polyphase DFT filterbank.
+ *
+ *  A single inverse real FFT converts the subbands back to ``num_bands`` time
+ *  samples, which are periodically extended to ``length`` samples, weighted by
+ *  the prototype and overlap-added. ``hop`` completed output samples are
+ *  produced per frame. Analysis followed directly by synthesis reconstructs
+ *  the input delayed by ``length`` - ``hop`` samples.
+ *
+ *  \param  filterbank  Filterbank object.
+ *  \param  spectrum    The subband samples in the format produced by
+ *                      dsp_filterbank_analyse(); overwritten.
+ *  \param  output      The ``hop`` output samples, oldest first.
+ */
+
+void dsp_filterbank_synthesise
+(
+    REFERENCE_PARAM(dsp_filterbank_t, filterbank),
+    dsp_complex_t spectrum[],
+    int32_t       output[]
+);
+
+#endif
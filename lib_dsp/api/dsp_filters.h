@@ -5,9 +5,12 @@
 #define DSP_FILTERS_H_
 
 #include "stdint.h"
+#include "xccompat.h"
+#include "dsp_complex.h"
 
 #define DSP_NUM_COEFFS_PER_BIQUAD 5  // Number of coefficients per biquad
 #define DSP_NUM_STATES_PER_BIQUAD 4  // Number of state values per biquad
+#define DSP_NUM_STATES_PER_BIQUAD_EF 6  // Number of state values per error feedback biquad
 
 /** This function implements a Finite Impulse Response (FIR) filter.
  *
@@ -60,6 +63,98 @@ int32_t dsp_filters_fir
     const int32_t q_format
 );
 
+/** This group of functions implements Finite Impulse Response (FIR) filters
+ *  with a tap count fixed at compile time.
+ *
+ *  ``dsp_filters_fir_16``, ``dsp_filters_fir_24``, ``dsp_filters_fir_32``,
+ *  ``dsp_filters_fir_64`` and ``dsp_filters_fir_128`` each compute the same
+ *  result as dsp_filters_fir() with ``num_taps`` equal to the number in the
+ *  function name, bit for bit, and use the same coefficient and state layout.
+ *  Each is fully unrolled, so there is no loop control and no dispatch on the
+ *  remaining tap count at run time.
+ *
+ *  Use DSP_FILTERS_FIR_FIXED() to select a kernel from a compile-time
+ *  constant tap count:
+ *
+ *  \code
+ *  #define NUM_TAPS 32
+ *  int32_t filter_coeffs[NUM_TAPS];
+ *  int32_t filter_state[NUM_TAPS-1];
+ *  int32_t result = DSP_FILTERS_FIR_FIXED( sample, filter_coeffs, filter_state, NUM_TAPS, 28 );
+ *  \endcode
+ *
+ *  The coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_sample    The new sample to be processed.
+ *  \param  filter_coeffs   Pointer to FIR coefficients array arranged
+ *                          as ``[b0,b1,b2,...,bN-1]``.
+ *  \param  state_data      Pointer to filter state data array of length N-1.
+ *                          Must be initialized at startup to all zeros.
+ *  \param  q_format        Fixed point format (i.e. number of fractional bits).
+ *  \returns                The resulting filter output sample.
+ */
+
+int32_t dsp_filters_fir_16
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[16],
+    int32_t       state_data[15],
+    const int32_t q_format
+);
+
+/** 24-tap FIR filter, see dsp_filters_fir_16(). */
+
+int32_t dsp_filters_fir_24
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[24],
+    int32_t       state_data[23],
+    const int32_t q_format
+);
+
+/** 32-tap FIR filter, see dsp_filters_fir_16(). */
+
+int32_t dsp_filters_fir_32
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[32],
+    int32_t       state_data[31],
+    const int32_t q_format
+);
+
+/** 64-tap FIR filter, see dsp_filters_fir_16(). */
+
+int32_t dsp_filters_fir_64
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[64],
+    int32_t       state_data[63],
+    const int32_t q_format
+);
+
+/** 128-tap FIR filter, see dsp_filters_fir_16(). */
+
+int32_t dsp_filters_fir_128
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[128],
+    int32_t       state_data[127],
+    const int32_t q_format
+);
+
+/** Selects the fixed-length FIR kernel for a tap count known at compile time.
+ *
+ *  Takes the same arguments as dsp_filters_fir(). ``num_taps`` must be an
+ *  integer literal, or a macro expanding to one, from the set 16, 24, 32, 64
+ *  and 128; any other value fails to compile rather than falling back to a
+ *  run-time loop.
+ */
+
+#define DSP_FILTERS_FIR_FIXED(input_sample, filter_coeffs, state_data, num_taps, q_format) \
+    _DSP_FILTERS_FIR_FIXED(input_sample, filter_coeffs, state_data, num_taps, q_format)
+#define _DSP_FILTERS_FIR_FIXED(input_sample, filter_coeffs, state_data, num_taps, q_format) \
+    dsp_filters_fir_##num_taps(input_sample, filter_coeffs, state_data, q_format)
+
 /** This function pushes samples into an Finite Impulse Response (FIR) filter
  *  state array, without processing the filter.
  *
@@ -141,6 +236,264 @@ void dsp_filters_interpolate
     const int32_t q_format
 );
 
+/** This function implements an interpolating FIR filter on a block of input
+ *  samples.
+ *
+ *  The function operates on ``num_inputs`` input samples and outputs
+ *  ``num_inputs`` * ``interp_factor`` samples. The result is identical to
+ *  calling dsp_filters_interpolate() once for each input sample, and the
+ *  coefficient ordering and state layout are shared with that function so the
+ *  two may be mixed on the same filter.
+ *
+ *  The per-sample state shift and the sub-filter setup are done once per
+ *  input sample rather than once per call, and the sub-filters are evaluated
+ *  with the even-aligned inner product only. This requires the number of taps
+ *  per sub-filter (``num_taps`` / ``interp_factor``) to be even; pad the
+ *  prototype filter with zeros where necessary.
+ *
+ *  \param input_samples   The block of new samples to be processed.
+ *  \param num_inputs      Number of samples in ``input_samples``.
+ *  \param filter_coeffs   Pointer to FIR coefficients array arranged as for
+ *                         dsp_filters_interpolate().
+ *  \param state_data      Pointer to filter state data array of length
+ *                         ``num_taps`` / ``interp_factor``.
+ *                         Must be initialized at startup to all zeros.
+ *  \param num_taps        Number of filter taps (N = ``num_taps`` = filter order + 1).
+ *                         Must be a multiple of 2 * ``interp_factor``.
+ *  \param interp_factor   The interpolation factor/index (i.e. the up-sampling ratio).
+ *  \param output_samples  The resulting interpolated samples, of length
+ *                         ``num_inputs`` * ``interp_factor``.
+ *  \param q_format        Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_filters_interpolate_block
+(
+    const int32_t input_samples[],
+    const int32_t num_inputs,
+    const int32_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t interp_factor,
+    int32_t       output_samples[],
+    const int32_t q_format
+);
+
+/** Rational L/M polyphase resampler.
+ *
+ *  Holds the filter configuration and the running output phase of a
+ *  resampler that converts the sample rate by ``interp_factor`` /
+ *  ``decim_factor`` (e.g. 160/147 for 44.1 kHz to 48 kHz). Initialise with
+ *  dsp_filters_resampler_init() and do not modify the members directly.
+ */
+typedef struct {
+    const int32_t * UNSAFE filter_coeffs; ///< Polyphase coefficients.
+    int32_t * UNSAFE       state_data;    ///< Input history, newest first.
+    int32_t                phase_length;  ///< Taps per polyphase sub-filter.
+    int32_t                interp_factor; ///< Up-sampling ratio L.
+    int32_t                decim_factor;  ///< Down-sampling ratio M.
+    int32_t                phase;         ///< Phase of the next output sample.
+    int32_t                q_format;      ///< Fixed point format.
+} dsp_filters_resampler_t;
+
+/** This function initialises a rational L/M polyphase resampler.
+ *
+ *  The caller supplies the prototype low-pass filter coefficients, which
+ *  should be designed at the up-sampled rate (L times the input rate) with
+ *  a cut-off at the lower of the two Nyquist frequencies, and stored in the
+ *  same polyphase order as for dsp_filters_interpolate(), i.e. sub-filter
+ *  ``p`` holds ``bp,b(1L+p),b(2L+p),...``.
+ *
+ *  This function only stores the coefficient and state pointers in the
+ *  resampler object and clears the state data array.
+ *
+ *  \param resampler       Resampler object to initialise.
+ *  \param filter_coeffs   Pointer to polyphase FIR coefficients array.
+ *  \param state_data      Pointer to filter state data array of length
+ *                         ``num_taps`` / ``interp_factor``.
+ *  \param num_taps        Number of prototype filter taps. Must be a multiple
+ *                         of 2 * ``interp_factor``.
+ *  \param interp_factor   The up-sampling ratio L.
+ *  \param decim_factor    The down-sampling ratio M.
+ *  \param q_format        Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_filters_resampler_init
+(
+    REFERENCE_PARAM(dsp_filters_resampler_t, resampler),
+    const int32_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t interp_factor,
+    const int32_t decim_factor,
+    const int32_t q_format
+);
+
+/** This function resamples a block of input samples by a rational ratio L/M.
+ *
+ *  Output sample ``m`` lies at time ``m*M`` on the up-sampled (zero-stuffed)
+ *  time axis. For each output only the single polyphase sub-filter for phase
+ *  ``(m*M) mod L`` is evaluated against the input history, so the work per
+ *  output sample is ``num_taps`` / ``interp_factor`` multiply-accumulates
+ *  regardless of L and M. Zero-stuffed samples and discarded phases are never
+ *  computed.
+ *
+ *  The phase is carried across calls, so a stream may be split into blocks of
+ *  any size. The number of output samples produced by a call varies; it is at
+ *  most (``num_inputs`` * L + M - 1) / M.
+ *
+ *  \param resampler       Resampler object initialised by dsp_filters_resampler_init().
+ *  \param input_samples   The block of new samples to be processed.
+ *  \param num_inputs      Number of samples in ``input_samples``.
+ *  \param output_samples  The resulting resampled samples.
+ *  \returns               The number of samples written to ``output_samples``.
+ */
+
+int32_t dsp_filters_resampler_process
+(
+    REFERENCE_PARAM(dsp_filters_resampler_t, resampler),
+    const int32_t input_samples[],
+    const int32_t num_inputs,
+    int32_t       output_samples[]
+);
+
+#define DSP_FILTERS_ASRC_RATIO_Q 28  // Fixed point format of the ASRC ratio
+
+/** Asynchronous (Farrow) sample rate converter.
+ *
+ *  Holds the filter configuration, the conversion ratio and the fractional
+ *  position of the next output sample of an asynchronous sample rate
+ *  converter. Initialise with dsp_filters_asrc_init() and do not modify the
+ *  members directly.
+ */
+typedef struct {
+    const int32_t * UNSAFE filter_coeffs; ///< Farrow coefficients, see dsp_filters_asrc_design().
+    int32_t * UNSAFE       state_data;    ///< Input history, newest first.
+    int32_t                phase_length;  ///< Taps per polyphase sub-filter.
+    int32_t                num_phases;    ///< Number of polyphase sub-filters.
+    int32_t                poly_order;    ///< Order of the Farrow polynomial.
+    int32_t                ratio;         ///< Input samples per output sample.
+    int32_t                position;      ///< Position of the next output sample.
+    int32_t                q_format;      ///< Fixed point format.
+} dsp_filters_asrc_t;
+
+/** This function converts a prototype low-pass filter into the Farrow
+ *  coefficients used by the asynchronous sample rate converter.
+ *
+ *  The prototype is designed at ``num_phases`` times the input sample rate
+ *  and is split into ``num_phases`` polyphase sub-filters. Within each
+ *  sub-filter, the impulse response between phase ``p`` and phase ``p+1`` is
+ *  approximated by a polynomial in the fractional phase ``mu``:
+ *
+ *  \code
+ *  h(p+mu) = c0 + c1*mu + c2*mu^2 + c3*mu^3
+ *  \endcode
+ *
+ *  A ``poly_order`` of 1 interpolates linearly between adjacent phases; a
+ *  ``poly_order`` of 3 uses cubic Lagrange interpolation over phases ``p-1``
+ *  to ``p+2``. The output array is arranged as ``num_phases`` groups of
+ *  ``poly_order`` + 1 sub-filters of ``num_taps`` / ``num_phases`` taps each,
+ *  i.e. ``[p0:c0[],c1[],..,p1:c0[],c1[],..]``.
+ *
+ *  \param prototype       Prototype filter coefficients ``[b0,b1,...,bN-1]``.
+ *  \param num_taps        Number of prototype filter taps. Must be a multiple
+ *                         of 2 * ``num_phases``.
+ *  \param num_phases      Number of polyphase sub-filters.
+ *  \param poly_order      Order of the Farrow polynomial, 1 or 3.
+ *  \param filter_coeffs   Resulting coefficients, of length
+ *                         ``num_taps`` * (``poly_order`` + 1).
+ */
+
+void dsp_filters_asrc_design
+(
+    const int32_t prototype[],
+    const int32_t num_taps,
+    const int32_t num_phases,
+    const int32_t poly_order,
+    int32_t       filter_coeffs[]
+);
+
+/** This function initialises an asynchronous sample rate converter.
+ *
+ *  The state data array is cleared by this function. If ``ratio`` is not
+ *  supported the converter is initialised with a ratio of one and an error
+ *  is returned.
+ *
+ *  \param asrc            ASRC object to initialise.
+ *  \param filter_coeffs   Coefficients generated by dsp_filters_asrc_design().
+ *  \param state_data      Pointer to filter state data array of length
+ *                         ``num_taps`` / ``num_phases``.
+ *  \param num_taps        Number of prototype filter taps.
+ *  \param num_phases      Number of polyphase sub-filters.
+ *  \param poly_order      Order of the Farrow polynomial, 1 or 3.
+ *  \param ratio           Initial conversion ratio, see dsp_filters_asrc_set_ratio().
+ *  \param q_format        Fixed point format of the prototype coefficients
+ *                         (i.e. number of fractional bits).
+ *  \returns               0 on success, -1 if ``ratio`` is not supported.
+ */
+
+int32_t dsp_filters_asrc_init
+(
+    REFERENCE_PARAM(dsp_filters_asrc_t, asrc),
+    const int32_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t num_phases,
+    const int32_t poly_order,
+    const int32_t ratio,
+    const int32_t q_format
+);
+
+/** This function sets the conversion ratio of an asynchronous sample rate
+ *  converter.
+ *
+ *  The ratio is the number of input samples consumed per output sample
+ *  (i.e. input rate / output rate) in Q28 format (``DSP_FILTERS_ASRC_RATIO_Q``),
+ *  and must be greater than 0 and less than 4. It may be changed between any
+ *  two calls to dsp_filters_asrc_process(), for example from a clock-drift
+ *  estimator, and takes effect from the next output sample without any
+ *  discontinuity. A ratio outside this range is rejected and the current
+ *  ratio is kept.
+ *
+ *  \param asrc            ASRC object.
+ *  \param ratio           Input samples per output sample in Q28 format.
+ *  \returns               0 on success, -1 if ``ratio`` is out of range.
+ */
+
+int32_t dsp_filters_asrc_set_ratio
+(
+    REFERENCE_PARAM(dsp_filters_asrc_t, asrc),
+    const int32_t ratio
+);
+
+/** This function converts a block of input samples with an asynchronous
+ *  sample rate converter.
+ *
+ *  Each output sample is computed at a fractional position between input
+ *  samples. The position selects a polyphase sub-filter ``p`` and a fraction
+ *  ``mu``; the ``poly_order`` + 1 Farrow sub-filters of phase ``p`` are applied
+ *  to the input history and combined with Horner's rule in ``mu``.
+ *
+ *  The cost is fixed: one state update of ``num_taps`` / ``num_phases`` words
+ *  per input sample, and (``poly_order`` + 1) * ``num_taps`` / ``num_phases``
+ *  multiply-accumulates plus ``poly_order`` multiplies per output sample.
+ *  The number of output samples produced by a call varies with the ratio; it
+ *  is at most ``num_inputs`` * 2^28 / ``ratio`` + 1.
+ *
+ *  \param asrc            ASRC object initialised by dsp_filters_asrc_init().
+ *  \param input_samples   The block of new samples to be processed.
+ *  \param num_inputs      Number of samples in ``input_samples``.
+ *  \param output_samples  The resulting resampled samples.
+ *  \returns               The number of samples written to ``output_samples``.
+ */
+
+int32_t dsp_filters_asrc_process
+(
+    REFERENCE_PARAM(dsp_filters_asrc_t, asrc),
+    const int32_t input_samples[],
+    const int32_t num_inputs,
+    int32_t       output_samples[]
+);
+
 /** This function implements an decimating FIR filter.
  *
  *  The function operates on a single set of input samples whose count is equal
@@ -188,6 +541,114 @@ int32_t dsp_filters_decimate
     const int32_t q_format
 );
 
+/** This function implements a Finite Impulse Response (FIR) filter with
+ *  16-bit coefficients.
+ *
+ *  It computes the same filter as dsp_filters_fir(), but the coefficients
+ *  are ``int16_t`` values packed two per word, halving the coefficient memory
+ *  and the number of coefficient loads. The state data remains 32-bit and
+ *  products are accumulated in a 64-bit accumulator.
+ *
+ *  ``q_format`` is the number of fractional bits of the coefficients, from 1
+ *  to 15; the result has the same fixed-point format as the input samples.
+ *  The results are bit-exact with dsp_filters_fir() given coefficients
+ *  ``b[i] << 16`` and ``q_format + 16``.
+ *
+ *  \code
+ *  int16_t filter_coeff[5] = { Q14(0.5),Q14(-0.5),Q14(0.0),Q14(-0.5),Q14(0.5) };
+ *  int32_t filter_state[4] = { 0, 0, 0, 0 };
+ *  int32_t result = dsp_filters_fir_c16( sample, filter_coeff, filter_state, 5, 14 );
+ *  \endcode
+ *
+ *  The coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_sample    The new sample to be processed.
+ *  \param  filter_coeffs   Pointer to FIR coefficients array arranged
+ *                          as ``[b0,b1,b2,...,bN-1]``.
+ *  \param  state_data      Pointer to filter state data array of length N-1.
+ *                          Must be initialized at startup to all zeros.
+ *  \param  num_taps        Number of filter taps (N = ``num_taps`` = filter order + 1).
+ *  \param  q_format        Fixed point format of the coefficients (i.e. number of fractional bits).
+ *  \returns                The resulting filter output sample.
+ */
+
+int32_t dsp_filters_fir_c16
+(
+    int32_t       input_sample,
+    const int16_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t q_format
+);
+
+/** This function implements an interpolating FIR filter with 16-bit
+ *  coefficients.
+ *
+ *  It computes the same filter as dsp_filters_interpolate(), with ``int16_t``
+ *  coefficients packed two per word. The coefficient array uses the same
+ *  polyphase arrangement, and ``q_format`` is the number of fractional bits
+ *  of the coefficients, from 1 to 15 (see dsp_filters_fir_c16()).
+ *
+ *  The sub-filter length ``num_taps`` / ``interp_factor`` must be even, and
+ *  the coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param input_sample    The new sample to be processed.
+ *  \param filter_coeffs   Pointer to FIR coefficients array arranged as for
+ *                         dsp_filters_interpolate().
+ *  \param state_data      Pointer to filter state data array of length
+ *                         ``num_taps`` / ``interp_factor``.
+ *                         Must be initialized at startup to all zeros.
+ *  \param num_taps        Number of filter taps (N = ``num_taps`` = filter order + 1).
+ *  \param interp_factor   The interpolation factor/index (i.e. the up-sampling ratio).
+ *  \param output_samples  The resulting interpolated samples.
+ *  \param q_format        Fixed point format of the coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_filters_interpolate_c16
+(
+    int32_t       input_sample,
+    const int16_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t interp_factor,
+    int32_t       output_samples[],
+    const int32_t q_format
+);
+
+/** This function implements a decimating FIR filter with 16-bit
+ *  coefficients.
+ *
+ *  It computes the same filter as dsp_filters_decimate(), and takes the
+ *  ``decim_factor`` input samples of each call in the same order. The
+ *  coefficients are ``int16_t`` values packed two per word, and ``q_format``
+ *  is the number of fractional bits of the coefficients, from 1 to 15 (see
+ *  dsp_filters_fir_c16()). The results are bit-exact with
+ *  dsp_filters_decimate() given coefficients ``b[i] << 16`` and
+ *  ``q_format + 16``.
+ *
+ *  The coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_samples  The new samples to be decimated.
+ *  \param  filter_coeffs  Pointer to FIR coefficients array arranged
+ *                         as ``[b0,b1,b2,...,bN-1]``.
+ *  \param  state_data     Pointer to filter state data array of length N-1.
+ *                         Must be initialized at startup to all zeros.
+ *  \param  num_taps       Number of filter taps (N = num_taps = filter order + 1).
+ *  \param  decim_factor   The decimation factor/index (i.e. the down-sampling ratio).
+ *  \param  q_format       Fixed point format of the coefficients (i.e. number of fractional bits).
+ *  \returns               The resulting decimated sample.
+ */
+
+int32_t dsp_filters_decimate_c16
+(
+    int32_t       input_samples[],
+    const int16_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t decim_factor,
+    const int32_t q_format
+);
+
 /** This function implements a second order IIR filter (direct form I).
  *
  *  The function operates on a single sample of input and output data (i.e. and
@@ -283,4 +744,799 @@ int32_t dsp_filters_biquads
     const int32_t q_format
 );
 
+/** This function implements a second order IIR filter (direct form I) with
+ *  first-order error feedback.
+ *
+ *  The function operates on a single sample of input and output data and uses
+ *  the same difference equation and coefficient layout as
+ *  dsp_filters_biquad(). In addition, the low ``q_format`` bits of the 64-bit
+ *  accumulator that are discarded when the output is truncated to 32 bits are
+ *  kept in the state and added back into the accumulator on the next sample
+ *  (fraction saving). The output quantization noise is thereby shaped by
+ *  ``(1 - z^-1)``, which cancels the very high gain the recursive part of a
+ *  low-frequency filter applies to that noise near DC.
+ *
+ *  This gives close to the noise performance of a filter with 64-bit state
+ *  for filters whose poles are close to z = 1 (e.g. a 20 Hz high-pass or
+ *  low-pass filter at 96 kHz) at the cost of one extra load, mask and store
+ *  per sample over dsp_filters_biquad(). Coefficients should be represented
+ *  with at most 30 fractional bits so that ``-a1`` (close to 2.0) can be
+ *  represented.
+ *
+ *  \code
+ *  int32_t filter_coeff[DSP_NUM_COEFFS_PER_BIQUAD];
+ *  int32_t filter_state[DSP_NUM_STATES_PER_BIQUAD_EF] = { 0, 0, 0, 0, 0, 0 };
+ *  dsp_design_biquad_highpass( 20.0 / 96000.0, 0.707, filter_coeff, 30 );
+ *  int32_t result = dsp_filters_biquad_ef( sample, filter_coeff, filter_state, 30 );
+ *  \endcode
+ *
+ *  \param  input_sample   The new sample to be processed.
+ *  \param  filter_coeffs  Pointer to biquad coefficients array arranged as ``[b0,b1,b2,-a1,-a2]``.
+ *  \param  state_data     Pointer to filter state data array (initialized at startup to zeros).
+ *                         The length of the state data array is 6 (``DSP_NUM_STATES_PER_BIQUAD_EF``):
+ *                         ``[x[n-1],x[n-2],y[n-1],y[n-2],error,reserved]``. The
+ *                         reserved word keeps each section double-word aligned.
+ *  \param  q_format       Fixed point format (i.e. number of fractional bits).
+ *  \returns               The resulting filter output sample.
+ */
+
+int32_t dsp_filters_biquad_ef
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[DSP_NUM_COEFFS_PER_BIQUAD],
+    int32_t       state_data   [DSP_NUM_STATES_PER_BIQUAD_EF],
+    const int32_t q_format
+);
+
+/** This function implements a cascaded direct form I BiQuad filter with
+ *  first-order error feedback in every section.
+ *
+ *  Each section is computed as by dsp_filters_biquad_ef(); see that function
+ *  for a description of the error feedback. The coefficient layout is the same
+ *  as for dsp_filters_biquads().
+ *
+ *  \param  input_sample   The new sample to be processed.
+ *  \param  filter_coeffs  Pointer to biquad coefficients array for all BiQuad sections.
+ *                         Arranged as ``[section1:b0,b1,b2,-a1,-a2,...sectionN:b0,b1,b2,-a1,-a2]``.
+ *  \param  state_data     Pointer to filter state data array (initialized at startup to zeros).
+ *                         The length of the state data array is ``num_sections`` * 6.
+ *  \param  num_sections   Number of BiQuad sections.
+ *  \param  q_format       Fixed point format (i.e. number of fractional bits).
+ *  \returns               The resulting filter output sample.
+ */
+
+int32_t dsp_filters_biquads_ef
+(
+    int32_t       input_sample,
+    const int32_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_sections,
+    const int32_t q_format
+);
+
+/** This function implements a cascaded direct form I BiQuad filter operating
+ *  on a frame of samples.
+ *
+ *  The function processes ``frame_length`` samples per call. The output and
+ *  the final state are identical to calling dsp_filters_biquads() once for
+ *  each sample, and the coefficient and state layouts are shared with that
+ *  function so the two may be mixed on the same filter.
+ *
+ *  Rather than passing each sample through every section in turn, the whole
+ *  frame is passed through the first section, then through the second
+ *  section, and so on. Each section's five coefficients and four state
+ *  values are read from memory once per frame and the state is written back
+ *  once at the end of the frame, instead of once per sample.
+ *
+ *  Example showing a frame of 64 samples through an 8x cascaded Biquad filter
+ *  with samples and coefficients represented in Q28 fixed-point format:
+ *
+ *  \code
+ *  int32_t filter_coeff[8*DSP_NUM_COEFFS_PER_BIQUAD] = { ... not shown for brevity };
+ *  int32_t filter_state[8*DSP_NUM_STATES_PER_BIQUAD] = { 0, ... };
+ *  dsp_filters_biquads_block( frame, frame, 64, filter_coeff, filter_state, 8, 28 );
+ *  \endcode
+ *
+ *  \param  input_samples  The frame of new samples to be processed.
+ *  \param  output_samples The resulting filter output samples. May be the same
+ *                         array as ``input_samples``.
+ *  \param  frame_length   Number of samples in the frame.
+ *  \param  filter_coeffs  Pointer to biquad coefficients array for all BiQuad sections.
+ *                         Arranged as ``[section1:b0,b1,b2,-a1,-a2,...sectionN:b0,b1,b2,-a1,-a2]``.
+ *  \param  state_data     Pointer to filter state data array (initialized at startup to zeros).
+ *                         The length of the state data array is ``num_sections`` * 4.
+ *  \param  num_sections   Number of BiQuad sections.
+ *  \param  q_format       Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_filters_biquads_block
+(
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length,
+    const int32_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_sections,
+    const int32_t q_format
+);
+
+/** This function implements a multi-channel cascaded direct form I BiQuad
+ *  filter operating on a frame of samples.
+ *
+ *  The function processes ``frame_length`` samples of each of
+ *  ``num_channels`` channels in place. Each channel runs the difference
+ *  equation of dsp_filters_biquads(). The same cascade may be applied to
+ *  every channel, or each channel may have its own coefficients.
+ *
+ *  The frame is processed one section at a time. For each section and channel
+ *  the five coefficients and four state values are read from memory once,
+ *  the whole frame of that channel is filtered, and the state is written
+ *  back once, so coefficient and state traffic is amortised over the frame.
+ *
+ *  Example showing 8 channels of 32 interleaved samples through a shared
+ *  4x cascaded Biquad filter represented in Q28 fixed-point format:
+ *
+ *  \code
+ *  int32_t filter_coeff[4*DSP_NUM_COEFFS_PER_BIQUAD] = { ... not shown for brevity };
+ *  int32_t filter_state[4*8*DSP_NUM_STATES_PER_BIQUAD] = { 0, ... };
+ *  int32_t frame[32*8];
+ *  dsp_filters_biquads_multichannel( frame, 8, 32, 1, filter_coeff, 0, filter_state, 4, 28 );
+ *  \endcode
+ *
+ *  The arithmetic of each section, including rounding and saturation, is the
+ *  same as for dsp_filters_biquad().
+ *
+ *  \param  samples            Frame of samples, filtered in place. If
+ *                             ``interleaved`` is non-zero, sample ``n`` of
+ *                             channel ``c`` is at index ``n*num_channels+c``,
+ *                             otherwise (planar) it is at
+ *                             ``c*frame_length+n``.
+ *  \param  num_channels       Number of channels.
+ *  \param  frame_length       Number of samples per channel.
+ *  \param  interleaved        Non-zero for an interleaved frame, zero for a
+ *                             planar frame.
+ *  \param  filter_coeffs      Pointer to biquad coefficients array arranged as
+ *                             ``[section1:b0,b1,b2,-a1,-a2,...sectionN:b0,b1,b2,-a1,-a2]``.
+ *                             If ``per_channel_coeffs`` is non-zero, one such
+ *                             set per channel follows the next.
+ *  \param  per_channel_coeffs Non-zero if each channel has its own coefficients.
+ *  \param  state_data         Pointer to filter state data array (initialized
+ *                             at startup to zeros) of length ``num_sections``
+ *                             * ``num_channels`` * 4. The four state values of
+ *                             all channels for one section are contiguous,
+ *                             i.e. ``[section1:ch1[4],ch2[4],...sectionN:...]``.
+ *  \param  num_sections       Number of BiQuad sections.
+ *  \param  q_format           Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_filters_biquads_multichannel
+(
+    int32_t       samples[],
+    const int32_t num_channels,
+    const int32_t frame_length,
+    const int32_t interleaved,
+    const int32_t filter_coeffs[],
+    const int32_t per_channel_coeffs,
+    int32_t       state_data[],
+    const int32_t num_sections,
+    const int32_t q_format
+);
+
+/** Smoothed BiQuad filter.
+ *
+ *  Holds the current and target coefficients and the state of a biquad
+ *  filter whose coefficients glide towards a target, for click-free
+ *  parameter changes. Initialise with dsp_filters_biquad_smooth_init() and
+ *  do not modify the members directly.
+ */
+typedef struct {
+    int32_t coeffs[DSP_NUM_COEFFS_PER_BIQUAD]; ///< Coefficients in use.
+    int32_t target[DSP_NUM_COEFFS_PER_BIQUAD]; ///< Coefficients being ramped to.
+    int32_t state[DSP_NUM_STATES_PER_BIQUAD];  ///< Filter state.
+    int32_t shift;                             ///< Smoothing time constant.
+    int32_t q_format;                          ///< Fixed point format.
+} dsp_filters_biquad_smooth_t;
+
+/** This function initialises a smoothed BiQuad filter.
+ *
+ *  Both the current and the target coefficients are set to
+ *  ``filter_coeffs`` and the filter state is cleared.
+ *
+ *  \param  filter         Smoothed BiQuad filter object.
+ *  \param  filter_coeffs  Initial biquad coefficients arranged as ``[b0,b1,b2,-a1,-a2]``.
+ *  \param  shift          Smoothing time constant. On every coefficient update
+ *                         the remaining difference to the target is reduced by
+ *                         a factor of ``1 - 2^-shift``.
+ *  \param  q_format       Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_filters_biquad_smooth_init
+(
+    REFERENCE_PARAM(dsp_filters_biquad_smooth_t, filter),
+    const int32_t filter_coeffs[DSP_NUM_COEFFS_PER_BIQUAD],
+    const int32_t shift,
+    const int32_t q_format
+);
+
+/** This function sets new target coefficients for a smoothed BiQuad filter.
+ *
+ *  The coefficients in use are not changed by this call; they move towards
+ *  the target during subsequent calls to dsp_filters_biquad_smooth_process().
+ *  A new target may be set at any time, including while a previous change is
+ *  still ramping, so a control can be tracked by designing the target once
+ *  per control change instead of redesigning the filter every few samples.
+ *
+ *  \param  filter         Smoothed BiQuad filter object.
+ *  \param  filter_coeffs  Target biquad coefficients arranged as ``[b0,b1,b2,-a1,-a2]``.
+ */
+
+void dsp_filters_biquad_smooth_set_target
+(
+    REFERENCE_PARAM(dsp_filters_biquad_smooth_t, filter),
+    const int32_t filter_coeffs[DSP_NUM_COEFFS_PER_BIQUAD]
+);
+
+/** This function processes a frame of samples through a smoothed BiQuad
+ *  filter.
+ *
+ *  Every ``update_interval`` samples, each coefficient is moved towards its
+ *  target by one first-order smoothing step:
+ *
+ *  \code
+ *  coeff = coeff + ((target - coeff) >> shift)
+ *  \endcode
+ *
+ *  and the following ``update_interval`` samples are filtered with the
+ *  updated coefficients, as by dsp_filters_biquads_block(). An
+ *  ``update_interval`` of 1 updates the coefficients on every sample; values
+ *  of 4 to 16 are usually inaudible and reduce the overhead of the ramp.
+ *
+ *  Each coefficient is stepped and truncated separately, and snaps to its
+ *  target once its step truncates to zero, so the intermediate ``[-a1,-a2]``
+ *  pairs are not exactly on the line from the initial to the target pair;
+ *  each can be off it by up to about 2^``shift`` least significant bits.
+ *  The set of stable pairs (the stability triangle) is convex, so the
+ *  intermediate filters are stable if the initial and the target pairs are
+ *  at least that far inside it. Filters with poles very close to the unit
+ *  circle are not covered by this.
+ *
+ *  \param  filter          Smoothed BiQuad filter object.
+ *  \param  input_samples   The frame of new samples to be processed.
+ *  \param  output_samples  The resulting filter output samples. May be the
+ *                          same array as ``input_samples``.
+ *  \param  frame_length    Number of samples in the frame.
+ *  \param  update_interval Number of samples between coefficient updates.
+ *                          Values less than 1 are treated as 1.
+ */
+
+void dsp_filters_biquad_smooth_process
+(
+    REFERENCE_PARAM(dsp_filters_biquad_smooth_t, filter),
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length,
+    const int32_t update_interval
+);
+
+#define DSP_FILTERS_CIC_MAX_ORDER 6  // Maximum number of CIC integrator/comb stages
+
+/** Cascaded integrator-comb (CIC) decimator.
+ *
+ *  Holds the integrator and comb state of a CIC decimator. Initialise with
+ *  dsp_filters_cic_init() and do not modify the members directly.
+ */
+typedef struct {
+    int32_t integrators[DSP_FILTERS_CIC_MAX_ORDER]; ///< Integrator state.
+    int32_t combs[DSP_FILTERS_CIC_MAX_ORDER];       ///< Comb delay state.
+    int32_t order;                                  ///< Number of stages.
+    int32_t decim_factor;                           ///< Decimation ratio R.
+    int32_t count;                                  ///< Inputs since the last output.
+    int32_t shift;                                  ///< Output normalisation shift.
+} dsp_filters_cic_t;
+
+/** This function initialises a CIC decimator.
+ *
+ *  The DC gain of an order ``N``, ratio ``R`` CIC filter is ``R^N``. The output
+ *  is shifted right by ``ceil(N * log2(R))`` bits, so that the overall DC gain
+ *  is ``R^N / 2^ceil(N * log2(R))``: exactly 1.0 when ``R`` is a power of two,
+ *  and less than 1.0 otherwise. dsp_design_cic_compensator() corrects
+ *  for the remaining gain.
+ *
+ *  \param  cic            CIC decimator object.
+ *  \param  order          Number of integrator and comb stages ``N``, from 1
+ *                         to ``DSP_FILTERS_CIC_MAX_ORDER``.
+ *  \param  decim_factor   The decimation ratio ``R``. ``R^N`` must not
+ *                         exceed 2^31.
+ */
+
+void dsp_filters_cic_init
+(
+    REFERENCE_PARAM(dsp_filters_cic_t, cic),
+    const int32_t order,
+    const int32_t decim_factor
+);
+
+/** This function decimates a block of samples with a CIC filter.
+ *
+ *  Each input sample passes through ``N`` integrators at the input rate, and
+ *  every ``R`` th integrator output passes through ``N`` combs at the output
+ *  rate, so the work per input sample is ``N`` additions independent of
+ *  ``R``. There are no multiplications.
+ *
+ *  The integrators wrap around using modulo 2^32 arithmetic; the wrap cancels
+ *  in the combs. The result is exact provided the full-precision output fits
+ *  in 32 bits, i.e. the input samples must have at least
+ *  ``ceil(N * log2(R))`` bits of headroom: for N = 4 and R = 64, inputs must
+ *  lie within +/- 2^7. This suits the narrow samples of PDM or sigma-delta
+ *  streams.
+ *
+ *  The decimation phase is carried across calls, so a stream may be split
+ *  into blocks of any size. The CIC response droops across the passband;
+ *  follow it with a FIR (e.g. dsp_filters_fir() or dsp_filters_decimate()) at
+ *  the output rate using coefficients from dsp_design_cic_compensator().
+ *
+ *  \param  cic            CIC decimator object initialised by dsp_filters_cic_init().
+ *  \param  input_samples  The block of new samples to be decimated.
+ *  \param  num_inputs     Number of samples in ``input_samples``.
+ *  \param  output_samples The resulting decimated samples, of length at most
+ *                         ``num_inputs`` / ``R`` + 1.
+ *  \returns               The number of samples written to ``output_samples``.
+ */
+
+int32_t dsp_filters_cic_decimate
+(
+    REFERENCE_PARAM(dsp_filters_cic_t, cic),
+    const int32_t input_samples[],
+    const int32_t num_inputs,
+    int32_t       output_samples[]
+);
+
+/** This function implements an all-zero (FIR) lattice filter.
+ *
+ *  The function operates on a single sample of input and output data (i.e.
+ *  each call to the function processes one sample).
+ *
+ *  Each stage ``m`` (``m = 1..M``) updates the forward and backward
+ *  prediction errors as
+ *
+ *  ``f[m](n) = f[m-1](n) + k[m] * g[m-1](n-1)``
+ *
+ *  ``g[m](n) = k[m] * f[m-1](n) + g[m-1](n-1)``
+ *
+ *  with ``f[0](n) = g[0](n) = x(n)`` and output ``y(n) = f[M](n)``. This is the
+ *  LPC analysis (whitening) filter for reflection coefficients ``k``; it is
+ *  the inverse of dsp_filters_lattice_allpole() with the same coefficients,
+ *  to within the rounding of the stage products.
+ *
+ *  Each stage product is computed with a 64-bit multiply-accumulate, rounded
+ *  and saturated, and shifted right by ``q_format`` bits. The reflection
+ *  coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_sample       The new sample to be processed.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  state_data         Pointer to filter state data array of length M.
+ *                             Must be initialized at startup to all zeros.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ *  \returns                   The resulting filter output sample.
+ */
+
+int32_t dsp_filters_lattice_allzero
+(
+    int32_t       input_sample,
+    const int32_t reflection_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** This function implements an all-pole (IIR) lattice filter.
+ *
+ *  The function operates on a single sample of input and output data (i.e.
+ *  each call to the function processes one sample).
+ *
+ *  Stages are processed from ``m = M`` down to ``m = 1``:
+ *
+ *  ``f[m-1](n) = f[m](n) - k[m] * g[m-1](n-1)``
+ *
+ *  ``g[m](n) = k[m] * f[m-1](n) + g[m-1](n-1)``
+ *
+ *  with ``f[M](n) = x(n)`` and output ``y(n) = f[0](n) = g[0](n)``. This is the
+ *  LPC synthesis filter; it is stable whenever every ``|k[m]| < 1``, which
+ *  makes it robust to coefficient quantisation and to coefficients changing
+ *  between samples. Every ``k[m]`` must lie strictly between -1 and +1; in
+ *  particular -1.0 (``INT32_MIN`` when ``q_format`` is 31) is not supported.
+ *
+ *  Each stage product is computed with a 64-bit multiply-accumulate, rounded
+ *  and saturated, and shifted right by ``q_format`` bits. The reflection
+ *  coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_sample       The new sample to be processed.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  state_data         Pointer to filter state data array of length M,
+ *                             holding ``[g0(n-1),...,gM-1(n-1)]``.
+ *                             Must be initialized at startup to all zeros.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ *  \returns                   The resulting filter output sample.
+ */
+
+int32_t dsp_filters_lattice_allpole
+(
+    int32_t       input_sample,
+    const int32_t reflection_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** This function implements a lattice-ladder (pole-zero) filter.
+ *
+ *  The all-pole lattice of dsp_filters_lattice_allpole() produces the backward
+ *  errors ``g[0](n)..g[M](n)``, and the output is their weighted sum
+ *
+ *  ``y(n) = v0*g[0](n) + v1*g[1](n) + ... + vM*g[M](n)``
+ *
+ *  accumulated in a 64-bit accumulator, saturated and shifted right by
+ *  ``q_format`` bits as in dsp_filters_fir(). This realises any stable IIR
+ *  transfer function with ``M`` poles and ``M`` zeros.
+ *
+ *  The coefficient and state arrays must be 64-bit (double-word) aligned.
+ *
+ *  \param  input_sample       The new sample to be processed.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  ladder_coeffs      Pointer to ladder coefficients array
+ *                             arranged as ``[v0,v1,...,vM]``.
+ *  \param  state_data         Pointer to filter state data array of length M.
+ *                             Must be initialized at startup to all zeros.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ *  \returns                   The resulting filter output sample.
+ */
+
+int32_t dsp_filters_lattice_ladder
+(
+    int32_t       input_sample,
+    const int32_t reflection_coeffs[],
+    const int32_t ladder_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** This function applies dsp_filters_lattice_allzero() to a frame of samples.
+ *
+ *  \param  input_samples      The frame of input samples.
+ *  \param  output_samples     The frame of output samples (may be the same
+ *                             array as ``input_samples``).
+ *  \param  frame_length       Number of samples in the frame.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  state_data         Pointer to filter state data array of length M.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_filters_lattice_allzero_block
+(
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length,
+    const int32_t reflection_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** This function applies dsp_filters_lattice_allpole() to a frame of samples.
+ *
+ *  \param  input_samples      The frame of input samples.
+ *  \param  output_samples     The frame of output samples (may be the same
+ *                             array as ``input_samples``).
+ *  \param  frame_length       Number of samples in the frame.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  state_data         Pointer to filter state data array of length M.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_filters_lattice_allpole_block
+(
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length,
+    const int32_t reflection_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** This function applies dsp_filters_lattice_ladder() to a frame of samples.
+ *
+ *  \param  input_samples      The frame of input samples.
+ *  \param  output_samples     The frame of output samples (may be the same
+ *                             array as ``input_samples``).
+ *  \param  frame_length       Number of samples in the frame.
+ *  \param  reflection_coeffs  Pointer to reflection coefficients array
+ *                             arranged as ``[k1,k2,...,kM]``.
+ *  \param  ladder_coeffs      Pointer to ladder coefficients array
+ *                             arranged as ``[v0,v1,...,vM]``.
+ *  \param  state_data         Pointer to filter state data array of length M.
+ *  \param  order              The number of lattice stages M.
+ *  \param  q_format           Fixed point format of the coefficients (i.e. number of fractional bits).
+ */
+
+void dsp_filters_lattice_ladder_block
+(
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length,
+    const int32_t reflection_coeffs[],
+    const int32_t ladder_coeffs[],
+    int32_t       state_data[],
+    const int32_t order,
+    const int32_t q_format
+);
+
+/** Running moving-average (boxcar) filter.
+ *
+ *  Holds the window of recent samples and their running sum. Initialise with
+ *  dsp_filters_moving_average_init() and do not modify the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE buffer; ///< Circular window of input samples.
+    int32_t          length; ///< Window length N.
+    int32_t          index;  ///< Slot holding the oldest sample.
+    int32_t          shift;  ///< log2(N) if N is a power of two, else -1.
+    int64_t          sum;    ///< Sum of the samples in the window.
+} dsp_filters_moving_average_t;
+
+/** This function initialises a moving-average filter.
+ *
+ *  The window is cleared, so the first ``length`` outputs ramp up from zero
+ *  as if the filter had been fed zeros.
+ *
+ *  \param  filter   Moving-average filter object.
+ *  \param  buffer   Window buffer of ``length`` words.
+ *  \param  length   Window length N.
+ */
+
+void dsp_filters_moving_average_init
+(
+    REFERENCE_PARAM(dsp_filters_moving_average_t, filter),
+    int32_t       buffer[],
+    const int32_t length
+);
+
+/** This function implements a moving-average (boxcar) filter.
+ *
+ *  ``y[n] = (x[n] + x[n-1] + ... + x[n-N+1]) / N``
+ *
+ *  The sum is kept as a 64-bit running total: each call adds the new sample
+ *  and subtracts the one leaving the window, so the cost per sample is
+ *  constant and independent of N, and the total is exact (no drift). The
+ *  mean is rounded to nearest; a power-of-two window length uses a shift
+ *  instead of a division.
+ *
+ *  \param  filter        Moving-average filter object.
+ *  \param  input_sample  The new sample to be processed.
+ *  \returns              The mean of the last N samples.
+ */
+
+int32_t dsp_filters_moving_average
+(
+    REFERENCE_PARAM(dsp_filters_moving_average_t, filter),
+    int32_t input_sample
+);
+
+/** This function applies dsp_filters_moving_average() to a frame of samples.
+ *
+ *  \param  filter          Moving-average filter object.
+ *  \param  input_samples   The frame of input samples.
+ *  \param  output_samples  The frame of output samples (may be the same
+ *                          array as ``input_samples``).
+ *  \param  frame_length    Number of samples in the frame.
+ */
+
+void dsp_filters_moving_average_block
+(
+    REFERENCE_PARAM(dsp_filters_moving_average_t, filter),
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length
+);
+
+/** Running median filter.
+ *
+ *  Holds the window of recent samples and a pair of heaps that keep the
+ *  window partially ordered. Initialise with dsp_filters_median_init() and
+ *  do not modify the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE data;     ///< Circular window of input samples.
+    int32_t * UNSAFE heap;     ///< Max-heap then min-heap of window slots.
+    int32_t * UNSAFE position; ///< Heap entry of each window slot.
+    int32_t          length;   ///< Window length N.
+    int32_t          lower;    ///< Size of the lower (max) heap.
+    int32_t          index;    ///< Slot holding the oldest sample.
+} dsp_filters_median_t;
+
+/** This function initialises a running median filter.
+ *
+ *  The window is cleared to zeros.
+ *
+ *  \param  filter   Median filter object.
+ *  \param  buffer   Work buffer of 3 * ``length`` words.
+ *  \param  length   Window length N.
+ */
+
+void dsp_filters_median_init
+(
+    REFERENCE_PARAM(dsp_filters_median_t, filter),
+    int32_t       buffer[],
+    const int32_t length
+);
+
+/** This function implements a running median filter.
+ *
+ *  Returns the median of the last N samples. For even N the result is the
+ *  mean of the two middle samples, rounded down.
+ *
+ *  The lower half of the window is kept in a max-heap and the upper half in
+ *  a min-heap, with the median at the heap roots. Each heap entry is indexed
+ *  by its window slot, so the oldest sample is overwritten in place and
+ *  sifted back into order; the cost per sample is O(log N) comparisons,
+ *  rather than the O(N log N) of sorting the window.
+ *
+ *  \param  filter        Median filter object.
+ *  \param  input_sample  The new sample to be processed.
+ *  \returns              The median of the last N samples.
+ */
+
+int32_t dsp_filters_median
+(
+    REFERENCE_PARAM(dsp_filters_median_t, filter),
+    int32_t input_sample
+);
+
+/** This function applies dsp_filters_median() to a frame of samples.
+ *
+ *  \param  filter          Median filter object.
+ *  \param  input_samples   The frame of input samples.
+ *  \param  output_samples  The frame of output samples (may be the same
+ *                          array as ``input_samples``).
+ *  \param  frame_length    Number of samples in the frame.
+ */
+
+void dsp_filters_median_block
+(
+    REFERENCE_PARAM(dsp_filters_median_t, filter),
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length
+);
+
+/** Sparse FIR filter.
+ *
+ *  Stores only the non-zero taps of a long FIR as (delay, coefficient)
+ *  pairs, and the input history in a circular buffer whose length is a power
+ *  of two. Initialise with dsp_filters_sparse_fir_init() and do not modify
+ *  the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE        history;  ///< Circular input history.
+    const uint32_t * UNSAFE delays;   ///< Delay of each non-zero tap, in samples.
+    const int32_t * UNSAFE  coeffs;   ///< Coefficient of each non-zero tap.
+    int32_t                 num_taps; ///< Number of non-zero taps.
+    uint32_t                mask;     ///< History length minus one.
+    uint32_t                index;    ///< Slot holding the newest sample.
+    int32_t                 q_format; ///< Fixed point format of the coefficients.
+} dsp_filters_sparse_fir_t;
+
+/** This function converts dense FIR coefficients to the (delay, coefficient)
+ *  pairs used by dsp_filters_sparse_fir().
+ *
+ *  Taps whose magnitude is greater than ``threshold`` are kept, in order of
+ *  increasing delay; a ``threshold`` of zero keeps every non-zero tap. At most
+ *  ``max_taps`` pairs are stored, but the number of taps that pass the
+ *  threshold is always returned, so a return value greater than ``max_taps``
+ *  means the output arrays were too small.
+ *
+ *  Example showing a measured echo path with small taps discarded:
+ *
+ *  \code
+ *  uint32_t delays[64];
+ *  int32_t  coeffs[64];
+ *  int32_t  n = dsp_filters_sparse_fir_from_dense( echo_path, 4096, Q28(0.001),
+ *                                                  delays, coeffs, 64 );
+ *  \endcode
+ *
+ *  \param  dense_coeffs  The dense filter coefficients ``[b0,b1,...,bN-1]``.
+ *  \param  num_dense     Number of dense coefficients N.
+ *  \param  threshold     Taps with magnitude at or below this are dropped.
+ *  \param  delays        The delay of each kept tap.
+ *  \param  coeffs        The coefficient of each kept tap.
+ *  \param  max_taps      Capacity of ``delays`` and ``coeffs``.
+ *  \returns              Number of taps that passed the threshold.
+ */
+
+int32_t dsp_filters_sparse_fir_from_dense
+(
+    const int32_t dense_coeffs[],
+    const int32_t num_dense,
+    const int32_t threshold,
+    uint32_t      delays[],
+    int32_t       coeffs[],
+    const int32_t max_taps
+);
+
+/** This function initialises a sparse FIR filter and clears its history.
+ *
+ *  \param  filter          Sparse FIR filter object.
+ *  \param  delays          Delay of each non-zero tap, in samples.
+ *  \param  coeffs          Coefficient of each non-zero tap.
+ *  \param  num_taps        Number of non-zero taps.
+ *  \param  history         History buffer of ``history_length`` words.
+ *  \param  history_length  History length; a power of two greater than the
+ *                          longest delay.
+ *  \param  q_format        Fixed point format of the coefficients (i.e.
+ *                          number of fractional bits).
+ */
+
+void dsp_filters_sparse_fir_init
+(
+    REFERENCE_PARAM(dsp_filters_sparse_fir_t, filter),
+    const uint32_t delays[],
+    const int32_t  coeffs[],
+    const int32_t  num_taps,
+    int32_t        history[],
+    const int32_t  history_length,
+    const int32_t  q_format
+);
+
+/** This function implements a sparse FIR filter.
+ *
+ *  ``y[n] = sum( coeffs[t] * x[n - delays[t]] )`` over the non-zero taps.
+ *
+ *  The new sample is written into the circular history and each tap reads
+ *  its sample at a masked offset, so the cost per sample is one 32-bit
+ *  multiply-accumulate per non-zero tap, independent of the longest delay.
+ *  Products are accumulated in a 64-bit accumulator, saturated and shifted
+ *  right by ``q_format`` bits with rounding, as in dsp_filters_fir().
+ *
+ *  \param  filter        Sparse FIR filter object.
+ *  \param  input_sample  The new sample to be processed.
+ *  \returns              The filtered sample.
+ */
+
+int32_t dsp_filters_sparse_fir
+(
+    REFERENCE_PARAM(dsp_filters_sparse_fir_t, filter),
+    int32_t input_sample
+);
+
+/** This function applies dsp_filters_sparse_fir() to a frame of samples.
+ *
+ *  The filter state is held in registers across the frame rather than being
+ *  reloaded for each sample.
+ *
+ *  \param  filter          Sparse FIR filter object.
+ *  \param  input_samples   The frame of input samples.
+ *  \param  output_samples  The frame of output samples (may be the same
+ *                          array as ``input_samples``).
+ *  \param  frame_length    Number of samples in the frame.
+ */
+
+void dsp_filters_sparse_fir_block
+(
+    REFERENCE_PARAM(dsp_filters_sparse_fir_t, filter),
+    const int32_t input_samples[],
+    int32_t       output_samples[],
+    const int32_t frame_length
+);
+
 #endif
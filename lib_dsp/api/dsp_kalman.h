@@ -0,0 +1,161 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+
+#ifndef DSP_KALMAN_H_
+#define DSP_KALMAN_H_
+
+#include "stdint.h"
+#include "xccompat.h"
+#include "dsp_complex.h"
+
+#define DSP_KALMAN_MAX_STATES 8  // Largest state dimension of a Kalman filter
+
+/** Linear Kalman filter.
+ *
+ *  Tracks a state vector ``x`` of ``n`` elements and its error covariance
+ *  ``P`` with the model
+ *
+ *  \code
+ *  x[t] = F * x[t-1] + w,  w ~ N( 0, Q )
+ *  z[t] = H * x[t] + v,    v ~ N( 0, diag(R) )
+ *  \endcode
+ *
+ *  where ``z`` holds ``m`` measurements with independent noise. Matrices are
+ *  stored row by row. The model arrays are only read, so filters with the
+ *  same model can share them. Initialise with dsp_kalman_init() and do not
+ *  modify the members directly.
+ */
+typedef struct {
+    int32_t * UNSAFE       state;             ///< State estimate x, n elements.
+    int32_t * UNSAFE       covariance;        ///< Error covariance P, n x n.
+    const int32_t * UNSAFE transition;        ///< State transition F, n x n.
+    const int32_t * UNSAFE process_noise;     ///< Process noise covariance Q, n x n.
+    const int32_t * UNSAFE observation;       ///< Observation matrix H, m x n.
+    const int32_t * UNSAFE measurement_noise; ///< Measurement noise variances R, m elements.
+    int32_t * UNSAFE       scratch;           ///< Scratch matrix, n x n.
+    int32_t                num_states;        ///< State dimension n.
+    int32_t                num_measurements;  ///< Measurements per update m.
+    int32_t                q_format;          ///< Fixed point format of all elements.
+} dsp_kalman_t;
+
+/** This function initialises a Kalman filter.
+ *
+ *  ``state`` and ``covariance`` must hold the initial estimate and its
+ *  covariance; they are updated in place by every step. All values share one
+ *  fixed point format, so choose ``q_format`` to resolve the smallest
+ *  variance of interest while leaving integer bits for the largest state and
+ *  covariance elements.
+ *
+ *  \param  kf                 Kalman filter object.
+ *  \param  num_states         State dimension n, from 2 to ``DSP_KALMAN_MAX_STATES``.
+ *  \param  num_measurements   Measurements per update m, from 1 to n.
+ *  \param  state              State estimate array of n elements.
+ *  \param  covariance         Covariance array of n * n elements; must be
+ *                             symmetric.
+ *  \param  transition         State transition matrix F of n * n elements.
+ *  \param  process_noise      Process noise covariance Q of n * n elements;
+ *                             must be symmetric.
+ *  \param  observation        Observation matrix H of m * n elements.
+ *  \param  measurement_noise  Variance of each of the m measurements.
+ *  \param  scratch            Scratch array of n * n elements, which may be
+ *                             shared by filters that are not stepped
+ *                             concurrently.
+ *  \param  q_format           Fixed point format (i.e. number of fractional bits).
+ */
+
+void dsp_kalman_init
+(
+    REFERENCE_PARAM(dsp_kalman_t, kf),
+    const int32_t num_states,
+    const int32_t num_measurements,
+    int32_t       state[],
+    int32_t       covariance[],
+    const int32_t transition[],
+    const int32_t process_noise[],
+    const int32_t observation[],
+    const int32_t measurement_noise[],
+    int32_t       scratch[],
+    const int32_t q_format
+);
+
+/** This function runs the prediction step of a Kalman filter:
+ *
+ *  \code
+ *  x = F * x
+ *  P = F * P * F' + Q
+ *  \endcode
+ *
+ *  ``F * P`` is formed once in the scratch matrix. Because ``P`` is
+ *  symmetric, its columns are read as rows, so every product is a
+ *  contiguous dot product with a single 64-bit accumulator and one rounding.
+ *  The second product accumulates onto ``Q`` and only computes the upper
+ *  triangle, which is mirrored, so ``P`` stays exactly symmetric. The cost is
+ *  about 1.5 * n^3 multiply-accumulates.
+ *
+ *  \param  kf  Kalman filter object.
+ */
+
+void dsp_kalman_predict
+(
+    REFERENCE_PARAM(dsp_kalman_t, kf)
+);
+
+/** This function runs the update step of a Kalman filter with a new set of
+ *  measurements.
+ *
+ *  As the measurement noise is independent, the ``m`` measurements are
+ *  applied one at a time, which needs one reciprocal per measurement instead
+ *  of an m x m matrix inverse. For each row ``h`` of ``H`` with variance
+ *  ``r`` and measurement ``z``:
+ *
+ *  \code
+ *  u = P * h'
+ *  s = h * u + r
+ *  k = u / s
+ *  x = x + k * (z - h * x)
+ *  P = (I - k * h) * P * (I - k * h)' + k * r * k'
+ *    = P - k * u' - u * k' + s * k * k'
+ *  \endcode
+ *
+ *  The covariance uses the Joseph form expanded as above, which needs no
+ *  temporary matrices: each element of the upper triangle is computed with
+ *  three multiply-accumulates into one 64-bit accumulator and rounded once,
+ *  and mirrored, so ``P`` stays exactly symmetric. As ``u``, ``s`` and
+ *  ``s * k`` are each rounded, the expansion is not an exact congruence of
+ *  ``P`` and positive definiteness is not guaranteed, but the update is
+ *  better conditioned than the usual ``P - k * u'``, whose error grows with
+ *  the rounding of the gain ``k``. The cost per measurement is about
+ *  2.5 * n^2 multiply-accumulates. A measurement whose innovation variance
+ *  ``s`` is not positive is skipped.
+ *
+ *  \param  kf            Kalman filter object.
+ *  \param  measurements  The m measurements z.
+ */
+
+void dsp_kalman_update
+(
+    REFERENCE_PARAM(dsp_kalman_t, kf),
+    const int32_t measurements[]
+);
+
+/** This function steps many independent Kalman filters, running
+ *  dsp_kalman_predict() and then dsp_kalman_update() on each.
+ *
+ *  The result is identical to calling the two functions on each filter in
+ *  turn. The filters may differ in size and model and may share model
+ *  arrays and a scratch matrix.
+ *
+ *  \param  kf            Array of ``num_filters`` Kalman filter objects.
+ *  \param  measurements  The measurements of each filter in turn, m of
+ *                        filter 0 followed by those of filter 1 and so on.
+ *  \param  num_filters   Number of filters.
+ */
+
+void dsp_kalman_step_batch
+(
+    dsp_kalman_t  kf[],
+    const int32_t measurements[],
+    const int32_t num_filters
+);
+
+#endif
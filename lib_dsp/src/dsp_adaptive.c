@@ -3,9 +3,11 @@
 #include <platform.h>
 #include "dsp_qformat.h"
 #include "dsp_math.h"
+#include "dsp_math_int.h"
 #include "dsp_filters.h"
 #include "dsp_vector.h"
 #include "dsp_statistics.h"
+#include "dsp_fft.h"
 #include "dsp_adaptive.h"
 
 
@@ -44,6 +46,96 @@ int32_t dsp_adaptive_lms
 
 
 
+// coeff + round( state * mu_err ), the coefficient update of dsp_vector_muls_addv().
+
+static inline int32_t _dsp_adaptive__lms_update
+(
+    int32_t       coeff,
+    int32_t       state,
+    int32_t       mu_err,
+    const int32_t q_format
+) {
+    int32_t ah; uint32_t al;
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(state),"r"(mu_err),"0"(0),"1"(1<<(q_format-1)));
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+    return coeff + ah;
+}
+
+int32_t dsp_adaptive_lms_fused
+(
+    int32_t  source_sample,
+    int32_t  reference_sample,
+    int32_t* error_sample,
+    const int32_t* filter_coeffs,
+    int32_t* state_data,
+    const int32_t num_taps,
+    const int32_t mu,
+    const int32_t q_format
+) {
+    int32_t* coeffs = (int32_t*) filter_coeffs;
+    int32_t  mu_err = dsp_math_multiply( *error_sample, mu, q_format );
+    int32_t  ah = 0, b0, b1, s0, s1, prev = source_sample;
+    uint32_t al = 1 << (q_format-1);
+    int32_t  output_sample;
+    int32_t  k;
+
+    // The state still holds x[n-1] ... x[n-N], the input the previous error was
+    // measured with. Each pair of taps is updated with that error, shifted along
+    // by one sample and multiplied into the output while it is in registers:
+    // b[k] = b[k] + mu_err * x[n-1-k], then y[n] += b[k] * x[n-k]
+
+    for( k = 0; k + 2 <= num_taps; k += 2 )
+    {
+        asm("ldd %0,%1,%2[%3]":"=r"(b1),"=r"(b0):"r"(coeffs),"r"(k >> 1));
+        asm("ldd %0,%1,%2[%3]":"=r"(s1),"=r"(s0):"r"(state_data),"r"(k >> 1));
+        b0 = _dsp_adaptive__lms_update( b0, s0, mu_err, q_format );
+        b1 = _dsp_adaptive__lms_update( b1, s1, mu_err, q_format );
+        asm("std %0,%1,%2[%3]"::"r"(b1),"r"(b0),"r"(coeffs),"r"(k >> 1));
+        asm("std %0,%1,%2[%3]"::"r"(s0),"r"(prev),"r"(state_data),"r"(k >> 1));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(prev),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s0),"0"(ah),"1"(al));
+        prev = s1;
+    }
+    if( k < num_taps )
+    {
+        b0 = _dsp_adaptive__lms_update( coeffs[k], state_data[k], mu_err, q_format );
+        coeffs[k] = b0;
+        state_data[k] = prev;
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(prev),"0"(ah),"1"(al));
+    }
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(output_sample):"r"(ah),"r"(al),"r"(q_format));
+
+    *error_sample = reference_sample - output_sample;
+    return output_sample;
+}
+
+
+
+// adjustment = error * mu / energy, with the reciprocal of the energy limited
+// to the range of the Q format.
+
+static int32_t _dsp_adaptive__nlms_adjustment
+(
+    int32_t       error,
+    int32_t       energy,
+    const int32_t mu,
+    const int32_t q_format
+) {
+    int32_t adjustment, ee, qq;
+
+    // Adjust energy q_format to account for range of reciprocal
+    for( qq = q_format, ee = energy; qq >= 0 && !(ee & 0x80000000); --qq ) ee <<= 1;
+    energy = energy >> (q_format - qq);
+    // Saturate the reciprocal value to max value for the given q_format
+    if( energy < (1 << (31-(31-qq)*2)) ) energy = (1 << (31-(31-qq)*2)) + 0;
+
+    energy = dsp_math_divide( (1 << qq), energy, qq );
+    adjustment = dsp_math_multiply( error, mu, q_format );
+    return dsp_math_multiply( energy, adjustment, qq + q_format - q_format );
+}
+
 int32_t dsp_adaptive_nlms
 (
     int32_t  source_sample,
@@ -55,7 +147,7 @@ int32_t dsp_adaptive_nlms
     const int32_t mu,
     const int32_t q_format
 ) {
-    int32_t output_sample, energy, adjustment, ee, qq;
+    int32_t output_sample, energy, adjustment;
     
     // Output signal y[n] is computed via standard FIR filter:
     // y[n] = b[0] * x[n] + b[1] * x[n-1] + b[2] * x[n-2] + ...+ b[N-1] * x[n-N+1]
@@ -71,17 +163,7 @@ int32_t dsp_adaptive_nlms
     energy = dsp_vector_power( state_data, num_taps, q_format );
     //printf( "E = %08x %f\n", energy, F31(energy) );
     
-    // adjustment = error * mu / energy
-    
-    // Adjust energy q_format to account for range of reciprocal
-    for( qq = q_format, ee = energy; qq >= 0 && !(ee & 0x80000000); --qq ) ee <<= 1;
-    energy = energy >> (q_format - qq);
-    // Saturate the reciprocal value to max value for the given q_format
-    if( energy < (1 << (31-(31-qq)*2)) ) energy = (1 << (31-(31-qq)*2)) + 0;
-
-    energy = dsp_math_divide( (1 << qq), energy, qq );
-    adjustment = dsp_math_multiply( *error_sample, mu, q_format );
-    adjustment = dsp_math_multiply( energy, adjustment, qq + q_format - q_format );
+    adjustment = _dsp_adaptive__nlms_adjustment( *error_sample, energy, mu, q_format );
     
     // FIR filter coefficients b[k] are updated on a sample-by-sample basis:
     // b[k] = b[k] + mu_err * x[n-k] --- where mu_err = e[n] * mu
@@ -90,3 +172,1083 @@ int32_t dsp_adaptive_nlms
         
     return output_sample;
 }
+
+
+
+// Exact sum of squares of the filter state, as accumulated by dsp_vector_power().
+
+static int64_t _dsp_adaptive__sum_of_squares( const int32_t* state_data, const int32_t num_taps )
+{
+    int64_t sum = 0;
+    for( int32_t i = 0; i < num_taps; ++i ) sum += (int64_t) state_data[i] * state_data[i];
+    return sum;
+}
+
+// A sum of squares saturated and shifted to q_format as in dsp_vector_power().
+
+static int32_t _dsp_adaptive__energy( int64_t sum, const int32_t q_format )
+{
+    sum >>= q_format;
+    return (sum > 0x7FFFFFFF) ? 0x7FFFFFFF : (int32_t) sum;
+}
+
+void dsp_adaptive_nlms_energy_init
+(
+    dsp_adaptive_nlms_energy_t* tracker,
+    const int32_t               state_data[],
+    const int32_t               num_taps,
+    const int32_t               resync_period
+) {
+    tracker->sum           = _dsp_adaptive__sum_of_squares( state_data, num_taps );
+    tracker->count         = 0;
+    tracker->resync_period = resync_period;
+}
+
+
+
+int32_t dsp_adaptive_nlms_running
+(
+    int32_t                     source_sample,
+    int32_t                     reference_sample,
+    int32_t*                    error_sample,
+    const int32_t*              filter_coeffs,
+    int32_t*                    state_data,
+    const int32_t               num_taps,
+    const int32_t               mu,
+    const int32_t               q_format,
+    dsp_adaptive_nlms_energy_t* tracker
+) {
+    int32_t output_sample, energy, adjustment;
+    int32_t oldest = state_data[num_taps - 1];
+    int64_t sum;
+
+    output_sample = dsp_filters_fir( source_sample, filter_coeffs, state_data, num_taps, q_format );
+    *error_sample = reference_sample - output_sample;
+
+    // E = x[n]^2 + ... + x[n-N+1]^2: add the new sample, drop the one that left the state
+    if( tracker->resync_period > 0 && ++tracker->count >= tracker->resync_period )
+    {
+        tracker->count = 0;
+        sum = _dsp_adaptive__sum_of_squares( state_data, num_taps );
+    }
+    else sum = tracker->sum + (int64_t) source_sample * source_sample - (int64_t) oldest * oldest;
+    tracker->sum = sum;
+    energy = _dsp_adaptive__energy( sum, q_format );
+
+    adjustment = _dsp_adaptive__nlms_adjustment( *error_sample, energy, mu, q_format );
+    dsp_vector_muls_addv( state_data, adjustment, (int32_t*) filter_coeffs, (int32_t*) filter_coeffs, num_taps, q_format );
+
+    return output_sample;
+}
+
+
+
+void dsp_adaptive_nlms_multi
+(
+    int32_t                     source_sample,
+    const int32_t               reference_samples[],
+    int32_t                     error_samples[],
+    int32_t                     output_samples[],
+    int32_t                     filter_coeffs[],
+    int32_t                     state_data[],
+    const int32_t               num_taps,
+    const int32_t               num_channels,
+    const int32_t               mu,
+    const int32_t               q_format,
+    dsp_adaptive_nlms_energy_t* tracker
+) {
+    int32_t  adjustment[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+    int32_t  acc_hi[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+    uint32_t acc_lo[DSP_ADAPTIVE_NLMS_MULTI_MAX_CHANNELS];
+    int32_t  energy = _dsp_adaptive__energy( tracker->sum, q_format );
+    int32_t  oldest = state_data[num_taps - 1];
+    int32_t  prev = source_sample;
+    int32_t  ah, b0, b1, s0, s1;
+    uint32_t al;
+    int64_t  sum;
+
+    // The previous errors were measured with the current state, whose energy the
+    // tracker still holds. A zero error needs no division; this covers the first
+    // call, where the state and so its energy are still zero.
+    for( int32_t m = 0; m < num_channels; ++m )
+    {
+        adjustment[m] = (error_samples[m] == 0) ? 0 :
+            _dsp_adaptive__nlms_adjustment( error_samples[m], energy, mu, q_format );
+        acc_hi[m] = 0;
+        acc_lo[m] = 1 << (q_format-1);
+    }
+
+    // Each pair of state words is loaded once, applied to the coefficients of every
+    // channel, shifted along by one sample and multiplied into every output:
+    // b[m][k] = b[m][k] + adjustment[m] * x[n-1-k], then y[m] += b[m][k] * x[n-k]
+
+    for( int32_t k = 0; k < num_taps; k += 2 )
+    {
+        asm("ldd %0,%1,%2[%3]":"=r"(s1),"=r"(s0):"r"(state_data),"r"(k >> 1));
+        for( int32_t m = 0; m < num_channels; ++m )
+        {
+            int32_t* coeffs = filter_coeffs + m * num_taps;
+            asm("ldd %0,%1,%2[%3]":"=r"(b1),"=r"(b0):"r"(coeffs),"r"(k >> 1));
+            b0 = _dsp_adaptive__lms_update( b0, s0, adjustment[m], q_format );
+            b1 = _dsp_adaptive__lms_update( b1, s1, adjustment[m], q_format );
+            asm("std %0,%1,%2[%3]"::"r"(b1),"r"(b0),"r"(coeffs),"r"(k >> 1));
+            ah = acc_hi[m]; al = acc_lo[m];
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(prev),"0"(ah),"1"(al));
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s0),"0"(ah),"1"(al));
+            acc_hi[m] = ah; acc_lo[m] = al;
+        }
+        asm("std %0,%1,%2[%3]"::"r"(s0),"r"(prev),"r"(state_data),"r"(k >> 1));
+        prev = s1;
+    }
+
+    for( int32_t m = 0; m < num_channels; ++m )
+    {
+        ah = acc_hi[m]; al = acc_lo[m];
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        output_samples[m] = ah;
+        error_samples[m] = reference_samples[m] - ah;
+    }
+
+    // One energy update for all channels, as in dsp_adaptive_nlms_running()
+    if( tracker->resync_period > 0 && ++tracker->count >= tracker->resync_period )
+    {
+        tracker->count = 0;
+        sum = _dsp_adaptive__sum_of_squares( state_data, num_taps );
+    }
+    else sum = tracker->sum + (int64_t) source_sample * source_sample - (int64_t) oldest * oldest;
+    tracker->sum = sum;
+}
+
+
+
+// Block LMS, or NLMS if normalise is set. The frame is stored newest first in
+// state_data[0..L-1] ahead of the previous state in state_data[L..L+N-1], so
+// the state of sample j is the window starting at state_data[L-1-j]. The
+// update is the mean of the L sample gradients, so mu / L is applied to each.
+
+static void _dsp_adaptive__block
+(
+    const int32_t* source_samples,
+    const int32_t* reference_samples,
+    int32_t*       error_samples,
+    int32_t*       output_samples,
+    int32_t*       filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_taps,
+    const int32_t  block_length,
+    const int32_t  mu,
+    const int32_t  q_format,
+    const int32_t  normalise
+) {
+    int32_t  adjustment[DSP_ADAPTIVE_BLOCK_MAX_LENGTH];
+    int32_t  L = block_length, step = mu / block_length;
+    int32_t  ah;
+    uint32_t al;
+    int64_t  sum = 0;
+
+    if( normalise ) sum = _dsp_adaptive__sum_of_squares( state_data + L, num_taps );
+    for( int32_t j = 0; j < L; ++j ) state_data[L-1-j] = source_samples[j];
+
+    // Block FIR with the coefficients of the previous frame:
+    // y[j] = b[0] * x[j][0] + ... + b[N-1] * x[j][N-1]
+
+    for( int32_t j = 0; j < L; ++j )
+    {
+        const int32_t* x = state_data + L-1-j;
+        ah = 0; al = 1 << (q_format-1);
+        for( int32_t k = 0; k < num_taps; ++k )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(filter_coeffs[k]),"r"(x[k]),"0"(ah),"1"(al));
+        }
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        output_samples[j] = ah;
+        error_samples[j] = reference_samples[j] - ah;
+
+        if( normalise )
+        {
+            sum += (int64_t) x[0] * x[0] - (int64_t) x[num_taps] * x[num_taps];
+            adjustment[j] = _dsp_adaptive__nlms_adjustment( error_samples[j], _dsp_adaptive__energy( sum, q_format ), step, q_format );
+        }
+        else adjustment[j] = dsp_math_multiply( error_samples[j], step, q_format );
+    }
+
+    // Mean gradient accumulated over the frame and applied once per tap:
+    // b[k] = b[k] + adjustment[0] * x[0][k] + ... + adjustment[L-1] * x[L-1][k]
+
+    for( int32_t k = 0; k < num_taps; ++k )
+    {
+        const int32_t* x = state_data + L-1 + k;
+        ah = 0; al = 1 << (q_format-1);
+        for( int32_t j = 0; j < L; ++j )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(adjustment[j]),"r"(x[-j]),"0"(ah),"1"(al));
+        }
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        filter_coeffs[k] += ah;
+    }
+
+    // The newest N samples become the previous state of the next frame
+    for( int32_t k = num_taps - 1; k >= 0; --k ) state_data[L + k] = state_data[k];
+}
+
+void dsp_adaptive_lms_block
+(
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       error_samples[],
+    int32_t       output_samples[],
+    int32_t       filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t block_length,
+    const int32_t mu,
+    const int32_t q_format
+) {
+    _dsp_adaptive__block( input_samples, reference_samples, error_samples, output_samples,
+                          filter_coeffs, state_data, num_taps, block_length, mu, q_format, 0 );
+}
+
+void dsp_adaptive_nlms_block
+(
+    const int32_t input_samples[],
+    const int32_t reference_samples[],
+    int32_t       error_samples[],
+    int32_t       output_samples[],
+    int32_t       filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t block_length,
+    const int32_t mu,
+    const int32_t q_format
+) {
+    _dsp_adaptive__block( input_samples, reference_samples, error_samples, output_samples,
+                          filter_coeffs, state_data, num_taps, block_length, mu, q_format, 1 );
+}
+
+
+
+// Extra fractional bits carried by a normalised gain or error spectrum, removed
+// again when it is multiplied by the input.
+#define _DSP_ADAPTIVE__GRADIENT_BITS 16
+
+// Returns mu / d as a 32-bit mantissa; the gain is that mantissa shifted right
+// by *shift bits, including the _DSP_ADAPTIVE__GRADIENT_BITS extra
+// fractional bits in q_format.
+
+static uint32_t _dsp_adaptive__normalised_gain( int32_t mu, uint64_t d, int32_t* shift )
+{
+    uint32_t hi = d >> 32, lo = d, r;
+    int32_t  n;
+
+    // 1/d = r * 2^(n-95), with d normalised to 32 bits and r = 2^63 / d
+    if( hi ) { asm("clz %0,%1":"=r"(n):"r"(hi)); }
+    else { asm("clz %0,%1":"=r"(n):"r"(lo)); n += 32; }
+    r = 0x7FFFFFFFFFFFFFFFULL / (uint32_t)((d << n) >> 32);
+
+    *shift = 63 - n - _DSP_ADAPTIVE__GRADIENT_BITS;
+    return ((uint64_t) mu * r) >> 32;
+}
+
+// Number of significant bits in the magnitude of a 64-bit value.
+
+static int32_t _dsp_adaptive__bits( uint64_t x )
+{
+    uint32_t hi = x >> 32, lo = x;
+    int32_t  n;
+
+    if( hi ) { asm("clz %0,%1":"=r"(n):"r"(hi)); return 64 - n; }
+    asm("clz %0,%1":"=r"(n):"r"(lo));
+    return 32 - n;
+}
+
+// Reduces gain * 2^-shift to a 32-bit gain and a shift from 1 to 31, the range
+// of dsp_vector_muls_addv() and _dsp_adaptive__lms_update().
+
+static int32_t _dsp_adaptive__reduce_gain( int64_t gain, int32_t* shift )
+{
+    int32_t k = _dsp_adaptive__bits( (gain < 0) ? -gain : gain ) - 31;
+
+    if( k > 0 ) { gain >>= k; *shift -= k; }
+    if( *shift > 31 ) { gain = (*shift - 31 >= 32) ? 0 : gain >> (*shift - 31); *shift = 31; }
+    if( *shift < 1 ) { gain = (gain < 0) ? -0x80000000LL : 0x7FFFFFFF; *shift = 1; }
+    return (int32_t) gain;
+}
+
+// Right shift of each product |b[k]| * x[n-k]^2 added to the IPNLMS weighted
+// sum: 31 bits after the first multiplication and 8 after the second. A
+// full-scale product of 2^93 becomes 2^54, so the sum of up to 512 taps fits
+// in 64 bits.
+#define _DSP_ADAPTIVE_IPNLMS__PRODUCT_SHIFT 39
+
+int32_t dsp_adaptive_ipnlms
+(
+    int32_t        source_sample,
+    int32_t        reference_sample,
+    int32_t*       error_sample,
+    const int32_t* filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_taps,
+    const int32_t  mu,
+    const int32_t  alpha,
+    const int32_t  q_format
+) {
+    int32_t* coeffs = (int32_t*) filter_coeffs;
+    int32_t  uniform = (int32_t)(((1LL << 30) - alpha) / (2 * num_taps));
+    uint32_t proportionate = ((1LL << 30) + alpha) >> 1;
+    int32_t  ah = 0, output_sample, adjustment, x, b, mag, prev = source_sample;
+    uint32_t al = 1 << (q_format-1), reciprocal = 0, norm32, gain;
+    uint64_t norm = 0, energy;
+    int64_t  sum = 0, weighted = 0;
+    int32_t  bits = 0, shift, weighted_shift;
+
+    // One pass shifts the state, computes the output and sums |b[k]|,
+    // |b[k]| * x[n-k]^2 and x[n-k]^2
+    for( int32_t k = 0; k < num_taps; ++k )
+    {
+        x = prev;
+        prev = state_data[k];
+        state_data[k] = x;
+        b = coeffs[k];
+        mag = (b < 0) ? -b : b;
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b),"r"(x),"0"(ah),"1"(al));
+        norm += (uint32_t) mag;
+        weighted += ((((int64_t) mag * x) >> 31) * x) >> (_DSP_ADAPTIVE_IPNLMS__PRODUCT_SHIFT - 31);
+        sum += (int64_t) x * x;
+    }
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(output_sample):"r"(ah),"r"(al),"r"(q_format));
+    *error_sample = reference_sample - output_sample;
+
+    // The proportionate part of each gain, (1 + alpha)/2 * |b[k]| / ||b||_1 in
+    // Q30, is |b[k]| * reciprocal >> bits, with ||b||_1 normalised to 32 bits
+    if( norm != 0 )
+    {
+        bits = _dsp_adaptive__bits( norm );
+        norm32 = (bits > 32) ? norm >> (bits - 32) : norm << (32 - bits);
+        reciprocal = ((uint64_t) proportionate << 32) / norm32;
+    }
+
+    // E = sum of g[k] * x[n-k]^2 = uniform * sum x^2 + proportionate * sum |b| x^2 / ||b||_1,
+    // in Q30 times q_format. The weighted sum is first brought to sum |b| x^2
+    // in q_format and saturated as _dsp_adaptive__energy() does. The
+    // ratio to ||b||_1 loses the coefficient format, which is restored by the
+    // shift. E is about N times smaller than the energy of dsp_adaptive_nlms(),
+    // so mu * error / E is kept as a mantissa and a shift.
+    weighted_shift = 2 * q_format - _DSP_ADAPTIVE_IPNLMS__PRODUCT_SHIFT;
+    if( weighted_shift >= 0 ) weighted >>= weighted_shift;
+    else weighted = (weighted > (0x7FFFFFFF >> -weighted_shift)) ? 0x7FFFFFFF : weighted << -weighted_shift;
+    if( weighted > 0x7FFFFFFF ) weighted = 0x7FFFFFFF;
+    weighted = (uint64_t) weighted * reciprocal;
+    energy = (bits >= q_format) ? weighted >> (bits - q_format) : weighted << (q_format - bits);
+    energy += (int64_t) uniform * _dsp_adaptive__energy( sum, q_format );
+    gain = _dsp_adaptive__normalised_gain( mu, energy + 1, &shift );
+    shift += _DSP_ADAPTIVE__GRADIENT_BITS + q_format - 30;
+    adjustment = _dsp_adaptive__reduce_gain( (int64_t) gain * *error_sample, &shift );
+
+    // b[k] = b[k] + adjustment * g[k] * x[n-k], with g[k] from the coefficient
+    // before its update, as used for E
+    if( adjustment != 0 ) for( int32_t k = 0; k < num_taps; ++k )
+    {
+        b = coeffs[k];
+        mag = (b < 0) ? -b : b;
+        x = (int32_t)(((int64_t) state_data[k] * (uniform + (int32_t)(((uint64_t) mag * reciprocal) >> bits))
+            + (1 << 29)) >> 30);
+        coeffs[k] = _dsp_adaptive__lms_update( b, x, adjustment, shift );
+    }
+
+    return output_sample;
+}
+
+
+
+int32_t dsp_adaptive_pbfdaf_init
+(
+    dsp_adaptive_pbfdaf_t* filter,
+    const int32_t          block_length,
+    const int32_t          num_partitions,
+    dsp_complex_t          spectra[],
+    dsp_complex_t          weights[],
+    dsp_complex_t          scratch[],
+    uint64_t               power[],
+    int32_t                history[],
+    const int32_t          mu,
+    const int32_t          power_shift,
+    const int32_t          min_level,
+    const int32_t          constrained,
+    const int32_t          q_format
+) {
+    if( num_partitions < 1 ) return -1;
+
+    filter->spectra        = spectra;
+    filter->weights        = weights;
+    filter->scratch        = scratch;
+    filter->power          = power;
+    filter->history        = history;
+    filter->block_length   = block_length;
+    filter->num_partitions = num_partitions;
+    filter->newest         = 0;
+    filter->mu             = mu / num_partitions;
+    filter->power_shift    = power_shift;
+    filter->constrained    = constrained;
+    filter->q_format       = q_format;
+
+    // The real FFT of 2B points takes the sine tables for B and 2B points
+    switch( block_length )
+    {
+        case 4:     filter->sine = dsp_sine_4;     filter->sine2 = dsp_sine_8;     break;
+        case 8:     filter->sine = dsp_sine_8;     filter->sine2 = dsp_sine_16;    break;
+        case 16:    filter->sine = dsp_sine_16;    filter->sine2 = dsp_sine_32;    break;
+        case 32:    filter->sine = dsp_sine_32;    filter->sine2 = dsp_sine_64;    break;
+        case 64:    filter->sine = dsp_sine_64;    filter->sine2 = dsp_sine_128;   break;
+        case 128:   filter->sine = dsp_sine_128;   filter->sine2 = dsp_sine_256;   break;
+        case 256:   filter->sine = dsp_sine_256;   filter->sine2 = dsp_sine_512;   break;
+        case 512:   filter->sine = dsp_sine_512;   filter->sine2 = dsp_sine_1024;  break;
+        case 1024:  filter->sine = dsp_sine_1024;  filter->sine2 = dsp_sine_2048;  break;
+        case 2048:  filter->sine = dsp_sine_2048;  filter->sine2 = dsp_sine_4096;  break;
+        case 4096:  filter->sine = dsp_sine_4096;  filter->sine2 = dsp_sine_8192;  break;
+        case 8192:  filter->sine = dsp_sine_8192;  filter->sine2 = dsp_sine_16384; break;
+        default:    return -1;
+    }
+
+    // Expected power of a bin of the 1/2B scaled FFT of noise at min_level
+    filter->min_power = (uint64_t)((int64_t) min_level * min_level) / (2 * block_length);
+    if( filter->min_power == 0 ) filter->min_power = 1;
+
+    for( int32_t i = 0; i < block_length * num_partitions; ++i )
+    {
+        spectra[i].re = spectra[i].im = 0;
+        weights[i].re = weights[i].im = 0;
+    }
+    for( int32_t i = 0; i <= block_length; ++i ) power[i] = 0;
+    for( int32_t i = 0; i < block_length; ++i ) history[i] = 0;
+    return 0;
+}
+
+
+
+// Smooths the power of one bin and returns mu / (power + min_power) as
+// _dsp_adaptive__normalised_gain() does.
+
+static uint32_t _dsp_adaptive__pbfdaf_gain
+(
+    dsp_adaptive_pbfdaf_t* filter,
+    uint64_t*              power,
+    uint64_t               bin_power,
+    int32_t*               shift
+) {
+    uint64_t p = *power;
+
+    // Start from the first bin power rather than ramping up from zero
+    p = (p == 0) ? bin_power : p - (p >> filter->power_shift) + (bin_power >> filter->power_shift);
+    *power = p;
+    return _dsp_adaptive__normalised_gain( filter->mu, p + filter->min_power, shift );
+}
+
+static int32_t _dsp_adaptive__gain_scale( int32_t x, uint32_t gain, int32_t shift )
+{
+    int64_t t = (int64_t) x * gain;
+
+    if( shift >= 63 ) return 0;
+    if( shift >= 0 ) t >>= shift;
+    else if( t > (0x7FFFFFFFLL >> -shift) || t < (-0x80000000LL >> -shift) ) t = (t < 0) ? -0x80000000LL : 0x7FFFFFFF;
+    else t <<= -shift;
+    if( t > 0x7FFFFFFF ) return 0x7FFFFFFF;
+    if( t < -0x80000000LL ) return -0x80000000LL;
+    return (int32_t) t;
+}
+
+void dsp_adaptive_pbfdaf
+(
+    dsp_adaptive_pbfdaf_t* filter,
+    const int32_t          input_samples[],
+    const int32_t          reference_samples[],
+    int32_t                output_samples[],
+    int32_t                error_samples[]
+) {
+    int32_t        B         = filter->block_length;
+    int32_t        P         = filter->num_partitions;
+    int32_t        q_format  = filter->q_format;
+    dsp_complex_t* Y         = filter->scratch;
+    dsp_complex_t* E         = filter->scratch + B;
+    dsp_complex_t* G         = filter->scratch + 2 * B;
+    int32_t*       y         = (int32_t*) Y;
+    int32_t*       e         = (int32_t*) E;
+    int32_t*       g         = (int32_t*) G;
+    dsp_complex_t* X;
+    int32_t*       x;
+    uint32_t       gain;
+    int32_t        shift;
+
+    // The oldest input spectrum slot becomes the newest: X[0] = FFT( previous, new )
+    filter->newest = (filter->newest == 0) ? P - 1 : filter->newest - 1;
+    X = filter->spectra + filter->newest * B;
+    x = (int32_t*) X;
+    for( int32_t i = 0; i < B; ++i )
+    {
+        x[i]     = filter->history[i];
+        x[B + i] = filter->history[i] = input_samples[i];
+    }
+    dsp_fft_bit_reverse_and_forward_real( x, 2 * B, filter->sine, filter->sine2 );
+
+    // Y = sum of X[p] * W[p]; bin 0 packs the real DC and Nyquist bins
+    for( int32_t i = 0; i < B; ++i ) Y[i].re = Y[i].im = 0;
+    for( int32_t p = 0, slot = filter->newest; p < P; ++p, slot = (slot + 1 == P) ? 0 : slot + 1 )
+    {
+        dsp_complex_t* Xp = filter->spectra + slot * B;
+        dsp_complex_t* Wp = filter->weights + p * B;
+        dsp_complex_macc_vector( Y + 1, Xp + 1, Wp + 1, B - 1, q_format );
+        Y[0].re += ((int64_t) Xp[0].re * Wp[0].re) >> q_format;
+        Y[0].im += ((int64_t) Xp[0].im * Wp[0].im) >> q_format;
+    }
+    dsp_fft_bit_reverse_and_inverse_real( y, 2 * B, filter->sine, filter->sine2 );
+
+    // Overlap-save: only the second half of the circular convolution is valid
+    for( int32_t i = 0; i < B; ++i )
+    {
+        output_samples[i] = y[B + i];
+        error_samples[i]  = reference_samples[i] - y[B + i];
+        e[i]              = 0;
+        e[B + i]          = error_samples[i];
+    }
+    dsp_fft_bit_reverse_and_forward_real( e, 2 * B, filter->sine, filter->sine2 );
+
+    // Normalise each error bin by the smoothed power of the newest input bin
+    gain = _dsp_adaptive__pbfdaf_gain( filter, &filter->power[0], (int64_t) X[0].re * X[0].re, &shift );
+    E[0].re = _dsp_adaptive__gain_scale( E[0].re, gain, shift );
+    gain = _dsp_adaptive__pbfdaf_gain( filter, &filter->power[B], (int64_t) X[0].im * X[0].im, &shift );
+    E[0].im = _dsp_adaptive__gain_scale( E[0].im, gain, shift );
+    for( int32_t k = 1; k < B; ++k )
+    {
+        uint64_t bin_power = (uint64_t)((int64_t) X[k].re * X[k].re) + (uint64_t)((int64_t) X[k].im * X[k].im);
+        gain = _dsp_adaptive__pbfdaf_gain( filter, &filter->power[k], bin_power, &shift );
+        E[k].re = _dsp_adaptive__gain_scale( E[k].re, gain, shift );
+        E[k].im = _dsp_adaptive__gain_scale( E[k].im, gain, shift );
+    }
+
+    // W[p] += conj(X[p]) * E, optionally constrained to the first B taps. The
+    // unscaled inverse FFT multiplies by 2B, so the constrained gradient is
+    // computed log2(2B) bits smaller and shifted back up when it is added.
+    shift = _DSP_ADAPTIVE__GRADIENT_BITS;
+    if( filter->constrained ) for( int32_t n = 2 * B; n > 1; n >>= 1 ) ++shift;
+    for( int32_t p = 0, slot = filter->newest; p < P; ++p, slot = (slot + 1 == P) ? 0 : slot + 1 )
+    {
+        dsp_complex_t* Xp = filter->spectra + slot * B;
+        dsp_complex_t* Wp = filter->weights + p * B;
+        dsp_complex_mul_conjugate_vector3( G + 1, E + 1, Xp + 1, B - 1, shift );
+        G[0].re = ((int64_t) E[0].re * Xp[0].re) >> shift;
+        G[0].im = ((int64_t) E[0].im * Xp[0].im) >> shift;
+        if( filter->constrained )
+        {
+            dsp_fft_bit_reverse_and_inverse_real( g, 2 * B, filter->sine, filter->sine2 );
+            for( int32_t i = B; i < 2 * B; ++i ) g[i] = 0;
+            dsp_fft_bit_reverse_and_forward_real( g, 2 * B, filter->sine, filter->sine2 );
+        }
+        dsp_complex_add_vector_shl( Wp, G, B, shift - _DSP_ADAPTIVE__GRADIENT_BITS );
+    }
+}
+
+
+
+// Right shift of each subband power before it is added to the energy of its
+// band. A full-scale power of 2^63 becomes 2^55, so the energy of up to 512
+// taps fits in 64 bits. When a frame leaves the window, the sum loses exactly
+// the truncated value it gained, so the sum stays exact.
+#define _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT 8
+
+void dsp_adaptive_subband_init
+(
+    dsp_adaptive_subband_t* filter,
+    dsp_filterbank_t*       input_bank,
+    dsp_filterbank_t*       reference_bank,
+    const int32_t           num_taps,
+    dsp_complex_t           spectra[],
+    dsp_complex_t           weights[],
+    dsp_complex_t           scratch[],
+    uint64_t                power[],
+    const int32_t           mu,
+    const int32_t           min_level,
+    const int32_t           q_format
+) {
+    int32_t  K = input_bank->num_bands;
+    int32_t  B = K / 2;
+    int32_t  q = input_bank->q_format;
+    uint64_t norm = 0, p;
+
+    filter->input_bank     = input_bank;
+    filter->reference_bank = reference_bank;
+    filter->spectra        = spectra;
+    filter->weights        = weights;
+    filter->scratch        = scratch;
+    filter->power          = power;
+    filter->num_bins       = B;
+    filter->num_taps       = num_taps;
+    filter->newest         = 0;
+    filter->mu             = mu;
+    filter->q_format       = q_format;
+
+    // Expected energy of a band over num_taps frames of noise at min_level: the
+    // analysis scales each band by |prototype|^2 / K^2
+    for( int32_t i = 0; i < input_bank->length; ++i )
+        norm += (uint64_t)((int64_t) input_bank->prototype[i] * input_bank->prototype[i]) >> q;
+    p = (uint64_t)((int64_t) min_level * min_level) / ((uint64_t) K * K);
+    p = ((p * (norm >> (q/2))) >> (q - q/2)) * num_taps;
+    filter->min_power = p >> _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT;
+    if( filter->min_power == 0 ) filter->min_power = 1;
+
+    for( int32_t i = 0; i < B * num_taps; ++i )
+    {
+        spectra[i].re = spectra[i].im = 0;
+        weights[i].re = weights[i].im = 0;
+    }
+    for( int32_t i = 0; i <= B; ++i ) power[i] = 0;
+}
+
+
+
+// Truncated power of band b of a subband frame; band 0 is the real DC band in
+// X[0].re and band B the real Nyquist band in X[0].im.
+
+static uint64_t _dsp_adaptive__subband_power( const dsp_complex_t* X, int32_t b, int32_t B )
+{
+    int64_t re = (b == B) ? 0 : X[b].re;
+    int64_t im = (b == 0) ? 0 : (b == B) ? X[0].im : X[b].im;
+    return ((uint64_t)(re * re) + (uint64_t)(im * im)) >> _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT;
+}
+
+void dsp_adaptive_subband
+(
+    dsp_adaptive_subband_t* filter,
+    const int32_t           input_samples[],
+    const int32_t           reference_samples[],
+    int32_t                 error_samples[]
+) {
+    int32_t        B        = filter->num_bins;
+    int32_t        L        = filter->num_taps;
+    int32_t        q_format = filter->q_format;
+    uint64_t*      power    = filter->power;
+    dsp_complex_t* Y        = filter->scratch;
+    dsp_complex_t* E        = filter->scratch + B;
+    dsp_complex_t* G        = filter->scratch + 2 * B;
+    dsp_complex_t* X;
+    uint32_t       gain;
+    int32_t        shift;
+
+    // The oldest frame slot becomes the newest: its energy leaves the band sums
+    // and the energy of the new frame enters them
+    filter->newest = (filter->newest == 0) ? L - 1 : filter->newest - 1;
+    X = filter->spectra + filter->newest * B;
+    for( int32_t b = 0; b <= B; ++b ) power[b] -= _dsp_adaptive__subband_power( X, b, B );
+    dsp_filterbank_analyse( filter->input_bank, input_samples, X );
+    for( int32_t b = 0; b <= B; ++b ) power[b] += _dsp_adaptive__subband_power( X, b, B );
+
+    // Y = sum of W[k] * X[k]; bin 0 packs the real DC and Nyquist bands
+    for( int32_t b = 0; b < B; ++b ) Y[b].re = Y[b].im = 0;
+    for( int32_t k = 0, slot = filter->newest; k < L; ++k, slot = (slot + 1 == L) ? 0 : slot + 1 )
+    {
+        dsp_complex_t* Xk = filter->spectra + slot * B;
+        dsp_complex_t* Wk = filter->weights + k * B;
+        dsp_complex_macc_vector( Y + 1, Xk + 1, Wk + 1, B - 1, q_format );
+        Y[0].re += ((int64_t) Xk[0].re * Wk[0].re) >> q_format;
+        Y[0].im += ((int64_t) Xk[0].im * Wk[0].im) >> q_format;
+    }
+
+    // E = D - Y, and G = E normalised by the energy of each band
+    dsp_filterbank_analyse( filter->reference_bank, reference_samples, E );
+    dsp_complex_sub_vector( E, Y, B );
+    gain = _dsp_adaptive__normalised_gain( filter->mu, power[0] + filter->min_power, &shift );
+    G[0].re = _dsp_adaptive__gain_scale( E[0].re, gain, shift + _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT );
+    gain = _dsp_adaptive__normalised_gain( filter->mu, power[B] + filter->min_power, &shift );
+    G[0].im = _dsp_adaptive__gain_scale( E[0].im, gain, shift + _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT );
+    for( int32_t b = 1; b < B; ++b )
+    {
+        gain = _dsp_adaptive__normalised_gain( filter->mu, power[b] + filter->min_power, &shift );
+        G[b].re = _dsp_adaptive__gain_scale( E[b].re, gain, shift + _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT );
+        G[b].im = _dsp_adaptive__gain_scale( E[b].im, gain, shift + _DSP_ADAPTIVE_SUBBAND__POWER_SHIFT );
+    }
+
+    // W[k] += conj(X[k]) * G, with the extra fractional bits of G removed by the
+    // multiply; Y is free again and holds each product
+    for( int32_t k = 0, slot = filter->newest; k < L; ++k, slot = (slot + 1 == L) ? 0 : slot + 1 )
+    {
+        dsp_complex_t* Xk = filter->spectra + slot * B;
+        dsp_complex_t* Wk = filter->weights + k * B;
+        dsp_complex_mul_conjugate_vector3( Y + 1, G + 1, Xk + 1, B - 1, _DSP_ADAPTIVE__GRADIENT_BITS );
+        Y[0].re = ((int64_t) G[0].re * Xk[0].re) >> _DSP_ADAPTIVE__GRADIENT_BITS;
+        Y[0].im = ((int64_t) G[0].im * Xk[0].im) >> _DSP_ADAPTIVE__GRADIENT_BITS;
+        dsp_complex_add_vector( Wk, Y, B );
+    }
+
+    dsp_filterbank_synthesise( filter->reference_bank, E, error_samples );
+}
+
+
+
+// coeffs = coeffs + vector * gain * 2^-shift, with the 64-bit gain reduced as
+// by _dsp_adaptive__reduce_gain().
+
+static void _dsp_adaptive__add_scaled
+(
+    const int32_t* vector,
+    int64_t        gain,
+    int32_t        shift,
+    int32_t*       coeffs,
+    const int32_t  num_taps
+) {
+    int32_t g = _dsp_adaptive__reduce_gain( gain, &shift );
+    if( g != 0 ) dsp_vector_muls_addv( vector, g, coeffs, coeffs, num_taps, shift );
+}
+
+// Shifts the square-root matrix so that its largest entry has 29 - h bits,
+// where 2^h >= sqrt(N); each column norm then stays below 2^29.
+
+static void _dsp_adaptive__rls_renormalise( dsp_adaptive_rls_t* rls )
+{
+    int32_t* sqrt_p = rls->sqrt_p;
+    int32_t  count  = rls->num_taps * rls->num_taps;
+    uint32_t mask   = 0;
+    int32_t  h, shift;
+
+    for( int32_t i = 0; i < count; ++i ) mask |= (sqrt_p[i] < 0) ? -sqrt_p[i] : sqrt_p[i];
+    if( mask == 0 ) return;
+    for( h = 0; (1 << (2 * h)) < rls->num_taps; ++h );
+
+    shift = 29 - h - _dsp_adaptive__bits( mask );
+    if( shift > 0 ) for( int32_t i = 0; i < count; ++i ) sqrt_p[i] <<= shift;
+    if( shift < 0 ) for( int32_t i = 0; i < count; ++i ) sqrt_p[i] >>= -shift;
+    rls->exponent -= shift;
+}
+
+void dsp_adaptive_rls_init
+(
+    dsp_adaptive_rls_t* rls,
+    const int32_t       num_taps,
+    int32_t             sqrt_p[],
+    int64_t             products[],
+    int32_t             scratch[],
+    const int32_t       lambda,
+    const int32_t       delta,
+    const int32_t       q_format
+) {
+    uint32_t root, scale, r;
+    int32_t  h, n, z = 32 + (q_format & 1);
+
+    rls->sqrt_p   = sqrt_p;
+    rls->products = products;
+    rls->scratch  = scratch;
+    rls->num_taps = num_taps;
+    rls->lambda   = lambda;
+    rls->count    = 0;
+    rls->q_format = q_format;
+
+    // 1 / sqrt(lambda) in Q30
+    root = dsp_math_int_sqrt64( (uint64_t) lambda << 30 );
+    asm("ldivu %0,%1,%2,%3,%4":"=r"(rls->inverse_sqrt_lambda),"=r"(r):"r"(1 << 28),"r"(0),"r"(root));
+
+    // sqrt(P) = I / sqrt(delta) = diagonal * scale * 2^exponent, with the
+    // diagonal at 29 - h bits and the scale in [1,2) in Q30
+    for( h = 0; (1 << (2 * h)) < num_taps; ++h );
+    for( int32_t i = 0; i < num_taps * num_taps; ++i ) sqrt_p[i] = 0;
+    for( int32_t i = 0; i < num_taps; ++i ) sqrt_p[i * num_taps + i] = 1 << (29 - h);
+
+    root = dsp_math_int_sqrt64( (uint64_t) delta << z );  // sqrt(delta) * 2^(z/2)
+    asm("clz %0,%1":"=r"(n):"r"(root));
+    asm("ldivu %0,%1,%2,%3,%4":"=r"(scale),"=r"(r):"r"(1 << 30),"r"(0),"r"(root << n));
+    rls->exponent = (q_format + z) / 2 + n - 61 + h;
+    if( scale >= 0x80000000 ) { scale >>= 1; rls->exponent += 1; }
+    rls->scale = scale;
+}
+
+
+
+int32_t dsp_adaptive_rls
+(
+    int32_t             source_sample,
+    int32_t             reference_sample,
+    int32_t*            error_sample,
+    const int32_t*      filter_coeffs,
+    int32_t*            state_data,
+    dsp_adaptive_rls_t* rls
+) {
+    int32_t  num_taps = rls->num_taps;
+    int32_t  q_format = rls->q_format;
+    int32_t* sqrt_p   = rls->sqrt_p;
+    int32_t* u        = rls->scratch;
+    int32_t* v        = rls->scratch + num_taps;
+    int64_t* f        = rls->products;
+    int32_t  output_sample, a, k, shift;
+    uint32_t rho, gamma, root, recip, r, hi, lo;
+    uint64_t mask = 0, sum = 0, num, den;
+    int64_t  gain;
+
+    output_sample = dsp_filters_fir( source_sample, filter_coeffs, state_data, num_taps, q_format );
+    *error_sample = reference_sample - output_sample;
+
+    // f = sqrt(P)^T x, in 64 bits, then normalised to 27 bits and scaled by the
+    // mantissa of sqrt(P) into u; the real f is u * 2^(exponent - q_format + a)
+    for( int32_t i = 0; i < num_taps; ++i )
+    {
+        int32_t  ah = 0;
+        uint32_t al = 0;
+        for( int32_t j = 0; j < num_taps; ++j )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(sqrt_p[i * num_taps + j]),"r"(state_data[j]),"0"(ah),"1"(al));
+        }
+        f[i] = ((int64_t) ah << 32) | al;
+        mask |= (f[i] < 0) ? -f[i] : f[i];
+    }
+    if( mask != 0 )
+    {
+        a = _dsp_adaptive__bits( mask ) - 27;
+        for( int32_t i = 0; i < num_taps; ++i )
+        {
+            int64_t t = (a >= 0) ? f[i] >> a : f[i] << -a;
+            u[i] = (t * (int64_t) rls->scale) >> 30;
+        }
+        for( int32_t i = 0; i < num_taps; ++i ) sum += (int64_t) u[i] * u[i];
+
+        // rho = |f|^2 / (lambda + |f|^2), with lambda in Q30 expressed in units of sum
+        k = -30 - 2 * (rls->exponent - q_format + a);
+        num = sum;
+        if( k > 32 ) { num = (k - 32 >= 64) ? 0 : num >> (k - 32); den = (uint64_t) rls->lambda << 32; }
+        else if( k >= 0 ) den = (uint64_t) rls->lambda << k;
+        else den = (-k >= 32) ? 0 : (uint64_t) rls->lambda >> -k;
+        den += num;
+        shift = _dsp_adaptive__bits( den ) - 32;
+        if( shift > 0 ) { num >>= shift; den >>= shift; }
+        hi = num >> 2;
+        lo = num << 30;
+        asm("ldivu %0,%1,%2,%3,%4":"=r"(rho),"=r"(r):"r"(hi),"r"(lo),"r"((uint32_t) den));
+
+        // gamma = rho / (1 + sqrt(1 - rho)), the step of the rank-one downdate
+        root = dsp_math_int_sqrt64( (uint64_t)((1 << 30) - rho) << 30 );
+        asm("ldivu %0,%1,%2,%3,%4":"=r"(gamma),"=r"(r):"r"(rho >> 2),"r"(rho << 30),"r"((1 << 30) + root));
+
+        // Unit vector along f in Q30, via recip = 2^57 / |u|
+        root = dsp_math_int_sqrt64( sum );
+        asm("ldivu %0,%1,%2,%3,%4":"=r"(recip),"=r"(r):"r"(1 << 25),"r"(0),"r"(root));
+        for( int32_t i = 0; i < num_taps; ++i ) u[i] = ((int64_t) u[i] * recip) >> 27;
+
+        // v = sqrt(P) u: the gain vector P x / (lambda + |f|^2), up to a scalar
+        for( int32_t j = 0; j < num_taps; ++j )
+        {
+            int32_t  ah = 0;
+            uint32_t al = 1 << 29;
+            for( int32_t i = 0; i < num_taps; ++i )
+            {
+                asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(u[i]),"r"(sqrt_p[i * num_taps + j]),"0"(ah),"1"(al));
+            }
+            asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(30),"0"(ah),"1"(al));
+            asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(30));
+            v[j] = ah;
+        }
+
+        // b = b + v * error * rho * scale * 2^(q_format - a) / |u|
+        gain = (int64_t) *error_sample * (int64_t)(((uint64_t)(((uint64_t) rho * rls->scale) >> 30) * recip) >> 31);
+        _dsp_adaptive__add_scaled( v, gain, 56 + a - q_format, (int32_t*) filter_coeffs, num_taps );
+
+        // sqrt(P) = sqrt(P) - gamma * u v^T, one row at a time
+        for( int32_t i = 0; i < num_taps; ++i )
+        {
+            int32_t c = -(int32_t)(((int64_t) gamma * u[i] + (1 << 29)) >> 30);
+            dsp_vector_muls_addv( v, c, sqrt_p + i * num_taps, sqrt_p + i * num_taps, num_taps, 30 );
+        }
+    }
+
+    // The 1 / sqrt(lambda) of the update goes into the scale; the matrix is
+    // renormalised once every num_taps samples
+    rls->scale = ((uint64_t) rls->scale * rls->inverse_sqrt_lambda) >> 30;
+    if( rls->scale >= 0x80000000 ) { rls->scale >>= 1; rls->exponent += 1; }
+    if( ++rls->count >= num_taps )
+    {
+        rls->count = 0;
+        _dsp_adaptive__rls_renormalise( rls );
+    }
+
+    return output_sample;
+}
+
+
+
+// Pivots below 2^-CONDITION_BITS of the largest diagonal of X^T X are raised
+// to that level, which bounds the multipliers of L to 2^(CONDITION_BITS/2).
+#define _DSP_ADAPTIVE_APA__CONDITION_BITS 10
+
+// Right shift of each product x[i] x[j] added to the correlation sums. A
+// full-scale product of 2^62 becomes 2^54, so the sums of up to 512 taps fit
+// in 64 bits. The same shifted product is subtracted when its samples leave
+// the window, so the dropped bits do not accumulate.
+#define _DSP_ADAPTIVE_APA__PRODUCT_SHIFT 8
+
+// round( x^T b ) with the saturation of dsp_filters_fir(), for a state vector
+// at any word offset in the shared APA history.
+
+static int32_t _dsp_adaptive__apa_dot
+(
+    const int32_t* x,
+    const int32_t* b,
+    const int32_t  num_taps,
+    const int32_t  q_format
+) {
+    int32_t ah = 0;
+    uint32_t al = 1 << (q_format-1);
+
+    for( int32_t i = 0; i < num_taps; ++i )
+    {
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(x[i]),"r"(b[i]),"0"(ah),"1"(al));
+    }
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+    return ah;
+}
+
+void dsp_adaptive_apa_init
+(
+    dsp_adaptive_apa_t* apa,
+    const int32_t       num_taps,
+    const int32_t       order,
+    int32_t             state_data[],
+    const int32_t       mu,
+    const int32_t       delta,
+    const int32_t       q_format
+) {
+    apa->state_data = state_data;
+    apa->num_taps   = num_taps;
+    apa->order      = order;
+    apa->newest     = 0;
+    apa->mu         = mu;
+    apa->delta      = ((int64_t) delta << q_format) >> _DSP_ADAPTIVE_APA__PRODUCT_SHIFT;
+    apa->q_format   = q_format;
+
+    for( int32_t i = 0; i < num_taps + order - 1; ++i ) state_data[i] = 0;
+    for( int32_t i = 0; i < DSP_ADAPTIVE_APA_MAX_ORDER; ++i )
+    {
+        apa->reference[i] = 0;
+        for( int32_t j = 0; j < DSP_ADAPTIVE_APA_MAX_ORDER; ++j ) apa->correlation[i][j] = 0;
+    }
+}
+
+
+
+int32_t dsp_adaptive_apa
+(
+    int32_t             source_sample,
+    int32_t             reference_sample,
+    int32_t*            error_sample,
+    const int32_t*      filter_coeffs,
+    dsp_adaptive_apa_t* apa
+) {
+    int32_t  num_taps = apa->num_taps;
+    int32_t  order    = apa->order;
+    int32_t  q_format = apa->q_format;
+    int32_t* state    = apa->state_data;
+    int32_t  input[DSP_ADAPTIVE_APA_MAX_ORDER], oldest[DSP_ADAPTIVE_APA_MAX_ORDER];
+    int32_t  error[DSP_ADAPTIVE_APA_MAX_ORDER], shift[DSP_ADAPTIVE_APA_MAX_ORDER];
+    int32_t  gain[DSP_ADAPTIVE_APA_MAX_ORDER], gain_shift[DSP_ADAPTIVE_APA_MAX_ORDER];
+    int32_t  r[DSP_ADAPTIVE_APA_MAX_ORDER][DSP_ADAPTIVE_APA_MAX_ORDER];
+    uint32_t recip[DSP_ADAPTIVE_APA_MAX_ORDER];
+    int64_t  solution[DSP_ADAPTIVE_APA_MAX_ORDER];
+    int32_t  output_sample = 0, previous, minimum, se, sr, n;
+    uint32_t mask = 0, rem;
+    int64_t  diagonal = 0;
+
+    // The state vectors overlap: projection p filters x[n-p] ... x[n-p-N+1],
+    // which starts at word p of the history once x[n] has been shifted in.
+    // x[n-p-N] leaves the window of projection p.
+    for( int32_t p = 0; p < order; ++p ) oldest[p] = state[num_taps - 1 + p];
+    for( int32_t i = num_taps + order - 2; i > 0; --i ) state[i] = state[i - 1];
+    state[0] = source_sample;
+    for( int32_t p = 0; p < order; ++p ) input[p] = state[p];
+
+    previous    = apa->newest;
+    apa->newest = (previous == 0) ? order - 1 : previous - 1;
+    apa->reference[apa->newest] = reference_sample;
+
+    // e[p] = d[n-p] - x[n-p]^T b
+    for( int32_t p = 0, slot = apa->newest; p < order; ++p, slot = (slot + 1 == order) ? 0 : slot + 1 )
+    {
+        int32_t y = _dsp_adaptive__apa_dot( state + p, filter_coeffs, num_taps, q_format );
+        if( p == 0 ) output_sample = y;
+        error[p] = apa->reference[slot] - y;
+        mask |= (error[p] < 0) ? -error[p] : error[p];
+    }
+    *error_sample = error[0];
+
+    // First row of X^T X: r(l) = sum of x[n-k] x[n-k-l], slid along by one sample.
+    // Row i of the matrix is the first row from i samples ago.
+    for( int32_t l = 0; l < order; ++l )
+    {
+        apa->correlation[apa->newest][l] = apa->correlation[previous][l]
+            + (((int64_t) input[0] * input[l]) >> _DSP_ADAPTIVE_APA__PRODUCT_SHIFT)
+            - (((int64_t) oldest[0] * oldest[l]) >> _DSP_ADAPTIVE_APA__PRODUCT_SHIFT);
+    }
+
+    // R = X^T X + delta I, lower triangle, with the largest diagonal at 30 bits
+    for( int32_t i = 0, slot = apa->newest; i < order; ++i, slot = (slot + 1 == order) ? 0 : slot + 1 )
+    {
+        if( apa->correlation[slot][0] + apa->delta > diagonal ) diagonal = apa->correlation[slot][0] + apa->delta;
+    }
+    if( diagonal <= 0 || mask == 0 ) return output_sample;
+    sr = _dsp_adaptive__bits( diagonal ) - 30;
+    for( int32_t j = 0, slot = apa->newest; j < order; ++j, slot = (slot + 1 == order) ? 0 : slot + 1 )
+    {
+        for( int32_t i = j; i < order; ++i )
+        {
+            int64_t c = apa->correlation[slot][i - j] + ((i == j) ? apa->delta : 0);
+            r[i][j] = (sr >= 0) ? c >> sr : c << -sr;
+        }
+    }
+    minimum = (int32_t)((sr >= 0 ? diagonal >> sr : diagonal << -sr) >> _DSP_ADAPTIVE_APA__CONDITION_BITS);
+
+    // Errors normalised to 24 bits
+    se = _dsp_adaptive__bits( mask ) - 24;
+    for( int32_t p = 0; p < order; ++p ) solution[p] = (se >= 0) ? error[p] >> se : error[p] << -se;
+
+    // R = L D L^T: the multipliers of L (Q24) replace the lower triangle, and
+    // each pivot of D is kept as a reciprocal 2^62 / (pivot << shift)
+    for( int32_t j = 0; j < order; ++j )
+    {
+        int32_t pivot = (r[j][j] < minimum) ? minimum : r[j][j];
+        int32_t m[DSP_ADAPTIVE_APA_MAX_ORDER];
+
+        asm("clz %0,%1":"=r"(n):"r"(pivot));
+        asm("ldivu %0,%1,%2,%3,%4":"=r"(recip[j]),"=r"(rem):"r"(1 << 30),"r"(0),"r"((uint32_t) pivot << n));
+        shift[j] = n;
+        for( int32_t i = j + 1; i < order; ++i ) m[i] = ((int64_t) r[i][j] * recip[j]) >> (38 - n);
+        for( int32_t i = j + 1; i < order; ++i )
+        {
+            for( int32_t k = j + 1; k <= i; ++k ) r[i][k] -= ((int64_t) m[i] * r[k][j]) >> 24;
+        }
+        for( int32_t i = j + 1; i < order; ++i ) r[i][j] = m[i];
+    }
+
+    // Solve L y = e, then L^T a = D^-1 y; a = R^-1 e is held scaled by
+    // 2^(22 + sr - se), as the pivots are scaled by 2^-sr and the errors by
+    // 2^-se, and each division by a pivot leaves 22 fractional bits
+    for( int32_t i = 1; i < order; ++i )
+    {
+        for( int32_t j = 0; j < i; ++j ) solution[i] -= (r[i][j] * solution[j]) >> 24;
+    }
+    for( int32_t i = 0; i < order; ++i ) solution[i] = (solution[i] * recip[i]) >> (40 - shift[i]);
+    for( int32_t i = order - 2; i >= 0; --i )
+    {
+        for( int32_t k = i + 1; k < order; ++k ) solution[i] -= (r[k][i] * solution[k]) >> 24;
+    }
+
+    // b = b + mu * X a, in one pass over the coefficients
+    for( int32_t p = 0; p < order; ++p )
+    {
+        gain_shift[p] = 22 + _DSP_ADAPTIVE_APA__PRODUCT_SHIFT + sr - se;
+        gain[p] = _dsp_adaptive__reduce_gain( apa->mu * solution[p], &gain_shift[p] );
+    }
+    for( int32_t i = 0; i < num_taps; ++i )
+    {
+        int32_t b = filter_coeffs[i];
+        for( int32_t p = 0; p < order; ++p ) b = _dsp_adaptive__lms_update( b, state[i + p], gain[p], gain_shift[p] );
+        ((int32_t*) filter_coeffs)[i] = b;
+    }
+
+    return output_sample;
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+#include <platform.h>
+#include "dsp_complex.h"
+
+// The state is a ring of num_taps+1 complex samples stored twice (a mirror),
+// so the num_taps+1 most recent samples are always contiguous from the newest
+// one at state[index] onwards and no modulo arithmetic is needed in the
+// inner products. The extra sample lets two consecutive outputs be computed
+// together in block mode.
+
+
+
+void dsp_complex_fir_init
+(
+    dsp_complex_fir_t* fir,
+    dsp_complex_t      state[],
+    const uint32_t     num_taps
+) {
+    fir->state    = state;
+    fir->num_taps = num_taps;
+    fir->index    = 0;
+    for( uint32_t i = 0; i < 2 * (num_taps + 1); ++i ) state[i].re = state[i].im = 0;
+}
+
+
+
+static void _dsp_complex_fir__push( dsp_complex_fir_t* fir, dsp_complex_t sample )
+{
+    uint32_t length = fir->num_taps + 1;
+    uint32_t index  = (fir->index == 0) ? length - 1 : fir->index - 1;
+
+    fir->state[index] = fir->state[index + length] = sample;
+    fir->index = index;
+}
+
+
+
+dsp_complex_t dsp_complex_fir_process
+(
+    dsp_complex_fir_t*  fir,
+    dsp_complex_t       input_sample,
+    const dsp_complex_t coeffs[],
+    const uint32_t      Q
+) {
+    _dsp_complex_fir__push( fir, input_sample );
+    return dsp_complex_fir( fir->state, coeffs, fir->num_taps, fir->index, Q );
+}
+
+
+
+void dsp_complex_fir_process_block
+(
+    dsp_complex_fir_t*  fir,
+    const dsp_complex_t input_samples[],
+    dsp_complex_t       output_samples[],
+    const uint32_t      num_samples,
+    const dsp_complex_t coeffs[],
+    const uint32_t      Q
+) {
+    uint32_t n = 0;
+
+    for( ; n + 1 < num_samples; n += 2 )
+    {
+        int32_t ah0 = 0, ah1 = 0, ah2 = 0, ah3 = 0;
+        uint32_t al0 = 0, al1 = 0, al2 = 0, al3 = 0;
+        int32_t cr, ci, cin, dr, di, er, ei;
+        const dsp_complex_t* x;
+
+        _dsp_complex_fir__push( fir, input_samples[n] );
+        _dsp_complex_fir__push( fir, input_samples[n+1] );
+
+        // Output n+1 uses x[0..N-1] and output n uses x[1..N]: every
+        // coefficient and every history sample is loaded once for both.
+        x = fir->state + fir->index;
+        asm("ldd %0,%1,%2[0]":"=r"(ei),"=r"(er):"r"(x));
+        for( uint32_t k = 0; k < fir->num_taps; ++k )
+        {
+            asm("ldd %0,%1,%2[%3]":"=r"(ci),"=r"(cr):"r"(coeffs),"r"(k));
+            asm("ldd %0,%1,%2[%3]":"=r"(di),"=r"(dr):"r"(x),"r"(k+1));
+            cin = -ci;
+            asm("maccs %0,%1,%2,%3":"=r"(ah0),"=r"(al0):"r"(cr),"r"(er),"0"(ah0),"1"(al0));
+            asm("maccs %0,%1,%2,%3":"=r"(ah0),"=r"(al0):"r"(cin),"r"(ei),"0"(ah0),"1"(al0));
+            asm("maccs %0,%1,%2,%3":"=r"(ah1),"=r"(al1):"r"(cr),"r"(ei),"0"(ah1),"1"(al1));
+            asm("maccs %0,%1,%2,%3":"=r"(ah1),"=r"(al1):"r"(ci),"r"(er),"0"(ah1),"1"(al1));
+            asm("maccs %0,%1,%2,%3":"=r"(ah2),"=r"(al2):"r"(cr),"r"(dr),"0"(ah2),"1"(al2));
+            asm("maccs %0,%1,%2,%3":"=r"(ah2),"=r"(al2):"r"(cin),"r"(di),"0"(ah2),"1"(al2));
+            asm("maccs %0,%1,%2,%3":"=r"(ah3),"=r"(al3):"r"(cr),"r"(di),"0"(ah3),"1"(al3));
+            asm("maccs %0,%1,%2,%3":"=r"(ah3),"=r"(al3):"r"(ci),"r"(dr),"0"(ah3),"1"(al3));
+            er = dr; ei = di;
+        }
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah0):"r"(ah0),"r"(al0),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah1):"r"(ah1),"r"(al1),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah2):"r"(ah2),"r"(al2),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah3):"r"(ah3),"r"(al3),"r"(Q));
+        output_samples[n+1].re = ah0; output_samples[n+1].im = ah1;
+        output_samples[n].re   = ah2; output_samples[n].im   = ah3;
+    }
+    if( n < num_samples )
+        output_samples[n] = dsp_complex_fir_process( fir, input_samples[n], coeffs, Q );
+}
+
+
+
+dsp_complex_t dsp_complex_fir_process_real
+(
+    dsp_complex_fir_t*  fir,
+    dsp_complex_t       input_sample,
+    const int32_t       coeffs[],
+    const uint32_t      Q
+) {
+    int32_t ah0 = 0, ah1 = 0, c, dr, di;
+    uint32_t al0 = 0, al1 = 0;
+    const dsp_complex_t* x;
+    dsp_complex_t result;
+
+    _dsp_complex_fir__push( fir, input_sample );
+    x = fir->state + fir->index;
+    for( uint32_t k = 0; k < fir->num_taps; ++k )
+    {
+        c = coeffs[k];
+        asm("ldd %0,%1,%2[%3]":"=r"(di),"=r"(dr):"r"(x),"r"(k));
+        asm("maccs %0,%1,%2,%3":"=r"(ah0),"=r"(al0):"r"(c),"r"(dr),"0"(ah0),"1"(al0));
+        asm("maccs %0,%1,%2,%3":"=r"(ah1),"=r"(al1):"r"(c),"r"(di),"0"(ah1),"1"(al1));
+    }
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah0):"r"(ah0),"r"(al0),"r"(Q));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah1):"r"(ah1),"r"(al1),"r"(Q));
+    result.re = ah0; result.im = ah1;
+    return result;
+}
+
+
+
+void dsp_complex_fir_process_real_block
+(
+    dsp_complex_fir_t*  fir,
+    const dsp_complex_t input_samples[],
+    dsp_complex_t       output_samples[],
+    const uint32_t      num_samples,
+    const int32_t       coeffs[],
+    const uint32_t      Q
+) {
+    uint32_t n = 0;
+
+    for( ; n + 1 < num_samples; n += 2 )
+    {
+        int32_t ah0 = 0, ah1 = 0, ah2 = 0, ah3 = 0;
+        uint32_t al0 = 0, al1 = 0, al2 = 0, al3 = 0;
+        int32_t c, dr, di, er, ei;
+        const dsp_complex_t* x;
+
+        _dsp_complex_fir__push( fir, input_samples[n] );
+        _dsp_complex_fir__push( fir, input_samples[n+1] );
+
+        x = fir->state + fir->index;
+        asm("ldd %0,%1,%2[0]":"=r"(ei),"=r"(er):"r"(x));
+        for( uint32_t k = 0; k < fir->num_taps; ++k )
+        {
+            c = coeffs[k];
+            asm("ldd %0,%1,%2[%3]":"=r"(di),"=r"(dr):"r"(x),"r"(k+1));
+            asm("maccs %0,%1,%2,%3":"=r"(ah0),"=r"(al0):"r"(c),"r"(er),"0"(ah0),"1"(al0));
+            asm("maccs %0,%1,%2,%3":"=r"(ah1),"=r"(al1):"r"(c),"r"(ei),"0"(ah1),"1"(al1));
+            asm("maccs %0,%1,%2,%3":"=r"(ah2),"=r"(al2):"r"(c),"r"(dr),"0"(ah2),"1"(al2));
+            asm("maccs %0,%1,%2,%3":"=r"(ah3),"=r"(al3):"r"(c),"r"(di),"0"(ah3),"1"(al3));
+            er = dr; ei = di;
+        }
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah0):"r"(ah0),"r"(al0),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah1):"r"(ah1),"r"(al1),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah2):"r"(ah2),"r"(al2),"r"(Q));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah3):"r"(ah3),"r"(al3),"r"(Q));
+        output_samples[n+1].re = ah0; output_samples[n+1].im = ah1;
+        output_samples[n].re   = ah2; output_samples[n].im   = ah3;
+    }
+    if( n < num_samples )
+        output_samples[n] = dsp_complex_fir_process_real( fir, input_samples[n], coeffs, Q );
+}
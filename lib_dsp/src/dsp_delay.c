@@ -0,0 +1,176 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+#include <platform.h>
+#include "dsp_delay.h"
+
+
+
+void dsp_delay_line_init
+(
+    dsp_delay_line_t* delay_line,
+    int32_t           buffer[],
+    const int32_t     length
+) {
+    delay_line->buffer      = buffer;
+    delay_line->mask        = length - 1;
+    delay_line->write_index = 0;
+    for( int32_t i = 0; i < length; ++i ) buffer[i] = 0;
+}
+
+
+
+void dsp_delay_line_write
+(
+    dsp_delay_line_t* delay_line,
+    int32_t           sample
+) {
+    delay_line->buffer[delay_line->write_index] = sample;
+    delay_line->write_index = (delay_line->write_index + 1) & delay_line->mask;
+}
+
+
+
+void dsp_delay_line_write_block
+(
+    dsp_delay_line_t* delay_line,
+    const int32_t     samples[],
+    const int32_t     num_samples
+) {
+    int32_t* buffer = delay_line->buffer;
+    uint32_t index  = delay_line->write_index;
+    int32_t  first  = delay_line->mask + 1 - index;
+
+    // At most two contiguous runs: up to the end of the buffer, then from the start
+    if( first > num_samples ) first = num_samples;
+    for( int32_t i = 0; i < first; ++i ) buffer[index + i] = samples[i];
+    for( int32_t i = first; i < num_samples; ++i ) buffer[i - first] = samples[i];
+    delay_line->write_index = (index + num_samples) & delay_line->mask;
+}
+
+
+
+void dsp_delay_line_read
+(
+    dsp_delay_line_t* delay_line,
+    const uint32_t    delays[],
+    int32_t           outputs[],
+    const int32_t     num_taps
+) {
+    const int32_t* buffer = delay_line->buffer;
+    uint32_t       mask   = delay_line->mask;
+    uint32_t       newest = delay_line->write_index - 1;
+
+    for( int32_t t = 0; t < num_taps; ++t )
+        outputs[t] = buffer[(newest - delays[t]) & mask];
+}
+
+
+
+void dsp_delay_line_read_linear
+(
+    dsp_delay_line_t* delay_line,
+    const uint32_t    delays[],
+    int32_t           outputs[],
+    const int32_t     num_taps
+) {
+    const int32_t* buffer = delay_line->buffer;
+    uint32_t       mask   = delay_line->mask;
+    uint32_t       newest = delay_line->write_index - 1;
+
+    for( int32_t t = 0; t < num_taps; ++t )
+    {
+        uint32_t index = newest - (delays[t] >> DSP_DELAY_LINE_FRAC_BITS);
+        int32_t  w1 = (delays[t] & ((1 << DSP_DELAY_LINE_FRAC_BITS) - 1)) << (30 - DSP_DELAY_LINE_FRAC_BITS);
+        int32_t  w0 = (1 << 30) - w1;
+        int32_t  ah = 0;
+        uint32_t al = 1 << 29;
+
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w0),"r"(buffer[index & mask]),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w1),"r"(buffer[(index-1) & mask]),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(30));
+        outputs[t] = ah;
+    }
+}
+
+
+
+// Rounded division of a Q(3*FRAC_BITS) product of fractions down to Q30.
+
+static int32_t _dsp_delay_line__weight( int64_t product, int32_t divisor )
+{
+    int64_t d = (int64_t) divisor << (3 * DSP_DELAY_LINE_FRAC_BITS - 30);
+    return (int32_t)((product + (product >= 0 ? d/2 : -d/2)) / d);
+}
+
+void dsp_delay_line_read_cubic
+(
+    dsp_delay_line_t* delay_line,
+    const uint32_t    delays[],
+    int32_t           outputs[],
+    const int32_t     num_taps
+) {
+    const int64_t  one    = 1 << DSP_DELAY_LINE_FRAC_BITS;
+    const int32_t* buffer = delay_line->buffer;
+    uint32_t       mask   = delay_line->mask;
+    uint32_t       newest = delay_line->write_index - 1;
+
+    for( int32_t t = 0; t < num_taps; ++t )
+    {
+        uint32_t index = newest - (delays[t] >> DSP_DELAY_LINE_FRAC_BITS);
+        int64_t  x     = delays[t] & (one - 1);
+        int32_t  wm1, w0, w1, w2;
+        int32_t  ah = 0;
+        uint32_t al = 1 << 29;
+
+        // Lagrange weights for the samples at offsets -1, 0, +1 and +2
+        wm1 = _dsp_delay_line__weight( -x * (x - one) * (x - 2*one), 6 );
+        w0  = _dsp_delay_line__weight( (x + one) * (x - one) * (x - 2*one), 2 );
+        w1  = _dsp_delay_line__weight( -(x + one) * x * (x - 2*one), 2 );
+        w2  = _dsp_delay_line__weight( (x + one) * x * (x - one), 6 );
+
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(wm1),"r"(buffer[(index+1) & mask]),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w0),"r"(buffer[index & mask]),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w1),"r"(buffer[(index-1) & mask]),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w2),"r"(buffer[(index-2) & mask]),"0"(ah),"1"(al));
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(30),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(30));
+        outputs[t] = ah;
+    }
+}
+
+
+
+void dsp_delay_line_read_polyphase
+(
+    dsp_delay_line_t* delay_line,
+    const uint32_t    delays[],
+    int32_t           outputs[],
+    const int32_t     num_taps,
+    const int32_t     filter_coeffs[],
+    const int32_t     num_phases,
+    const int32_t     phase_length,
+    const int32_t     q_format
+) {
+    const int32_t* buffer = delay_line->buffer;
+    uint32_t       mask   = delay_line->mask;
+    uint32_t       newest = delay_line->write_index - 1;
+
+    for( int32_t t = 0; t < num_taps; ++t )
+    {
+        // Nearest phase; rounding up to num_phases selects phase 0 one sample later
+        uint32_t scaled = (uint32_t)(((uint64_t) delays[t] * num_phases
+                        + (1 << (DSP_DELAY_LINE_FRAC_BITS-1))) >> DSP_DELAY_LINE_FRAC_BITS);
+        uint32_t index  = newest - scaled / num_phases + (phase_length >> 1) - 1;
+        const int32_t* cc = filter_coeffs + (scaled % num_phases) * phase_length;
+        int32_t  ah = 0;
+        uint32_t al = 1 << (q_format-1);
+
+        for( int32_t k = 0; k < phase_length; ++k )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(cc[k]),"r"(buffer[(index-k) & mask]),"0"(ah),"1"(al));
+        }
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        outputs[t] = ah;
+    }
+}
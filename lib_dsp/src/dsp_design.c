@@ -3,6 +3,7 @@
 #include <platform.h>
 #include <stdio.h>
 #include <dsp_design.h>
+#include <dsp_filters.h>
 #include <math.h>
 
 static double pi = 3.14159265359;
@@ -252,3 +253,104 @@ void dsp_design_biquad_highshelf
 	coefficients[3] = _float2fixed( -a1/a0, q_format );
 	coefficients[4] = _float2fixed( -a2/a0, q_format );
 }
+
+
+
+void dsp_design_cic_compensator
+(
+    const int32_t cic_order,
+    const int32_t cic_decim_factor,
+    double        passband,
+    int32_t       coefficients[],
+    const int32_t num_taps,
+    const int32_t q_format
+) {
+    const int32_t grid = 1024;
+    double centre = (num_taps - 1) / 2.0;
+    dsp_filters_cic_t cic;
+    double gain;
+
+    // DC gain left after the CIC output shift: R^N / 2^ceil(N*log2(R))
+    dsp_filters_cic_init( &cic, cic_order, cic_decim_factor );
+    gain = pow( cic_decim_factor, cic_order ) / pow( 2.0, cic.shift );
+
+    for( int32_t n = 0; n < num_taps; ++n )
+    {
+        double sum = 0.0;
+
+        // Inverse DTFT of the (real, even) desired response over 0..0.5
+        for( int32_t k = 0; k <= grid; ++k )
+        {
+            double f = 0.5 * k / grid;
+            double desired = 0.0;
+            if( f < 0.5 )
+            {
+                double droop = (f == 0.0) ? 1.0 :
+                    pow( sin( pi * f ) / (cic_decim_factor * sin( pi * f / cic_decim_factor )), cic_order );
+                desired = 1.0 / droop;
+                if( f > passband )
+                    desired *= 0.5 + 0.5 * cos( pi * (f - passband) / (0.5 - passband) );
+            }
+            if( k == 0 || k == grid ) desired *= 0.5;
+            sum += desired * cos( 2.0 * pi * f * (n - centre) );
+        }
+        sum *= 2.0 * 0.5 / grid;
+
+        // Blackman window
+        sum *= 0.42 - 0.5 * cos( 2.0 * pi * (n + 0.5) / num_taps )
+                    + 0.08 * cos( 4.0 * pi * (n + 0.5) / num_taps );
+
+        coefficients[n] = _float2fixed( sum / gain, q_format );
+    }
+}
+
+
+
+// Root-raised-cosine tap n of a prototype with symbol period num_bands, with a
+// cosine taper over the outer quarter at each end (Tukey window).
+
+static double _dsp_design__prototype_tap( int32_t n, int32_t num_bands, int32_t length, double beta )
+{
+    double t = (n - (length - 1) / 2.0) / num_bands;
+    double h;
+
+    if( fabs( t ) < 1e-9 )
+        h = 1.0 - beta + 4.0 * beta / pi;
+    else if( fabs( fabs( 4.0 * beta * t ) - 1.0 ) < 1e-9 )
+        h = beta / sqrt( 2.0 ) * ((1.0 + 2.0 / pi) * sin( pi / (4.0 * beta ))
+                                + (1.0 - 2.0 / pi) * cos( pi / (4.0 * beta )));
+    else
+        h = (sin( pi * t * (1.0 - beta) ) + 4.0 * beta * t * cos( pi * t * (1.0 + beta) ))
+          / (pi * t * (1.0 - (4.0 * beta * t) * (4.0 * beta * t)));
+    t = (n + 0.5) / length;
+    if( t > 0.5 ) t = 1.0 - t;
+    if( t < 0.25 ) h *= 0.5 - 0.5 * cos( 4.0 * pi * t );
+    return h;
+}
+
+void dsp_design_filterbank_prototype
+(
+    const int32_t num_bands,
+    const int32_t hop,
+    int32_t       coefficients[],
+    const int32_t length,
+    const int32_t q_format
+) {
+    double beta   = 0.75 * ((double) num_bands / hop - 1.0);
+    double energy = 0.0;
+    double scale;
+
+    if( beta < 0.1 ) beta = 0.1;
+    if( beta > 1.0 ) beta = 1.0;
+
+    for( int32_t n = 0; n < length; ++n )
+    {
+        double h = _dsp_design__prototype_tap( n, num_bands, length, beta );
+        energy += h * h;
+    }
+
+    // Each output sample sums length/hop products of analysis and synthesis taps
+    scale = sqrt( hop / energy );
+    for( int32_t n = 0; n < length; ++n )
+        coefficients[n] = _float2fixed( _dsp_design__prototype_tap( n, num_bands, length, beta ) * scale, q_format );
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+#include <platform.h>
+#include "dsp_filterbank.h"
+#include "dsp_fft.h"
+
+
+
+int32_t dsp_filterbank_init
+(
+    dsp_filterbank_t* filterbank,
+    const int32_t     prototype[],
+    const int32_t     length,
+    const int32_t     num_bands,
+    const int32_t     hop,
+    int32_t           history[],
+    int32_t           overlap[],
+    const int32_t     q_format
+) {
+    if( num_bands < 8 || hop < 1 || num_bands % hop != 0 || length < num_bands || length % num_bands != 0 )
+        return -1;
+
+    filterbank->prototype = prototype;
+    filterbank->history   = history;
+    filterbank->overlap   = overlap;
+    filterbank->num_bands = num_bands;
+    filterbank->hop       = hop;
+    filterbank->length    = length;
+    filterbank->q_format  = q_format;
+
+    // The real FFT takes the sine tables for N/2 and N points
+    switch( num_bands )
+    {
+        case 8:     filterbank->sine = dsp_sine_4;     filterbank->sine2 = dsp_sine_8;     break;
+        case 16:    filterbank->sine = dsp_sine_8;     filterbank->sine2 = dsp_sine_16;    break;
+        case 32:    filterbank->sine = dsp_sine_16;    filterbank->sine2 = dsp_sine_32;    break;
+        case 64:    filterbank->sine = dsp_sine_32;    filterbank->sine2 = dsp_sine_64;    break;
+        case 128:   filterbank->sine = dsp_sine_64;    filterbank->sine2 = dsp_sine_128;   break;
+        case 256:   filterbank->sine = dsp_sine_128;   filterbank->sine2 = dsp_sine_256;   break;
+        case 512:   filterbank->sine = dsp_sine_256;   filterbank->sine2 = dsp_sine_512;   break;
+        case 1024:  filterbank->sine = dsp_sine_512;   filterbank->sine2 = dsp_sine_1024;  break;
+        case 2048:  filterbank->sine = dsp_sine_1024;  filterbank->sine2 = dsp_sine_2048;  break;
+        case 4096:  filterbank->sine = dsp_sine_2048;  filterbank->sine2 = dsp_sine_4096;  break;
+        case 8192:  filterbank->sine = dsp_sine_4096;  filterbank->sine2 = dsp_sine_8192;  break;
+        case 16384: filterbank->sine = dsp_sine_8192;  filterbank->sine2 = dsp_sine_16384; break;
+        default:    return -1;
+    }
+
+    for( int32_t i = 0; i < length; ++i ) history[i] = overlap[i] = 0;
+    return 0;
+}
+
+
+
+void dsp_filterbank_analyse
+(
+    dsp_filterbank_t* filterbank,
+    const int32_t     input[],
+    dsp_complex_t     spectrum[]
+) {
+    const int32_t* prototype = filterbank->prototype;
+    int32_t*       history   = filterbank->history;
+    int32_t*       folded    = (int32_t*) spectrum;
+    int32_t        num_bands = filterbank->num_bands;
+    int32_t        hop       = filterbank->hop;
+    int32_t        length    = filterbank->length;
+    int32_t        q_format  = filterbank->q_format;
+
+    // Slide the analysis window along by one hop
+    for( int32_t i = 0; i < length - hop; ++i ) history[i] = history[i + hop];
+    for( int32_t i = 0; i < hop; ++i ) history[length - hop + i] = input[i];
+
+    // Window and fold every num_bands'th sample onto the same FFT input
+    for( int32_t k = 0; k < num_bands; ++k )
+    {
+        int32_t  ah = 0;
+        uint32_t al = 1 << (q_format-1);
+
+        for( int32_t i = k; i < length; i += num_bands )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(prototype[i]),"r"(history[i]),"0"(ah),"1"(al));
+        }
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        folded[k] = ah;
+    }
+
+    dsp_fft_bit_reverse_and_forward_real( folded, num_bands, filterbank->sine, filterbank->sine2 );
+}
+
+
+
+void dsp_filterbank_synthesise
+(
+    dsp_filterbank_t* filterbank,
+    dsp_complex_t     spectrum[],
+    int32_t           output[]
+) {
+    const int32_t* prototype = filterbank->prototype;
+    int32_t*       overlap   = filterbank->overlap;
+    int32_t*       unfolded  = (int32_t*) spectrum;
+    int32_t        num_bands = filterbank->num_bands;
+    int32_t        hop       = filterbank->hop;
+    int32_t        length    = filterbank->length;
+    int32_t        q_format  = filterbank->q_format;
+
+    dsp_fft_bit_reverse_and_inverse_real( unfolded, num_bands, filterbank->sine, filterbank->sine2 );
+
+    // Extend the FFT output periodically over the window, weight and overlap-add
+    for( int32_t i = 0; i < length; ++i )
+    {
+        int32_t  ah = 0;
+        uint32_t al = 1 << (q_format-1);
+
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(prototype[i]),"r"(unfolded[i & (num_bands-1)]),"0"(ah),"1"(al));
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        overlap[i] += ah;
+    }
+
+    // The first hop samples have received every contribution they will get
+    for( int32_t i = 0; i < hop; ++i ) output[i] = overlap[i];
+    for( int32_t i = 0; i < length - hop; ++i ) overlap[i] = overlap[i + hop];
+    for( int32_t i = length - hop; i < length; ++i ) overlap[i] = 0;
+}
@@ -716,6 +716,91 @@ int32_t dsp_filters_fir
     return ah;
 }
 
+
+
+// Building blocks for the fixed-length FIR kernels below. Each step shifts the
+// state by two words and accumulates two taps; four-tap groups alternate the
+// s0..s3 registers exactly as in dsp_filters_fir so the results are bit-exact.
+
+#define _DSP_FILTERS_FIR__TAPS2A(i) \
+    asm("ldd %0,%1,%2[" #i "]":"=r"(b1),"=r"(b0):"r"(filter_coeffs)); \
+    asm("ldd %0,%1,%2[" #i "]":"=r"(s2),"=r"(s1):"r"(state_data)); \
+    asm("std %0,%1,%2[" #i "]"::"r"(s1), "r"(s0),"r"(state_data)); \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s0),"0"(ah),"1"(al)); \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s1),"0"(ah),"1"(al));
+
+#define _DSP_FILTERS_FIR__TAPS2B(i) \
+    asm("ldd %0,%1,%2[" #i "]":"=r"(b1),"=r"(b0):"r"(filter_coeffs)); \
+    asm("ldd %0,%1,%2[" #i "]":"=r"(s0),"=r"(s3):"r"(state_data)); \
+    asm("std %0,%1,%2[" #i "]"::"r"(s3), "r"(s2),"r"(state_data)); \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s2),"0"(ah),"1"(al)); \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s3),"0"(ah),"1"(al));
+
+// Final two taps: only N-1 state words exist, so the last word is stored alone
+#define _DSP_FILTERS_FIR__TAPS2B_LAST(i) \
+    asm("ldd %0,%1,%2[" #i "]":"=r"(b1),"=r"(b0):"r"(filter_coeffs)); \
+    s3 = state_data[2*i]; \
+    state_data[2*i] = s2; \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s2),"0"(ah),"1"(al)); \
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s3),"0"(ah),"1"(al));
+
+#define _DSP_FILTERS_FIR__TAPS16 \
+    _DSP_FILTERS_FIR__TAPS2A(0) _DSP_FILTERS_FIR__TAPS2B(1) \
+    _DSP_FILTERS_FIR__TAPS2A(2) _DSP_FILTERS_FIR__TAPS2B(3) \
+    _DSP_FILTERS_FIR__TAPS2A(4) _DSP_FILTERS_FIR__TAPS2B(5) \
+    _DSP_FILTERS_FIR__TAPS2A(6) _DSP_FILTERS_FIR__TAPS2B(7) \
+    filter_coeffs += 16; state_data += 16;
+
+#define _DSP_FILTERS_FIR__TAPS16_LAST \
+    _DSP_FILTERS_FIR__TAPS2A(0) _DSP_FILTERS_FIR__TAPS2B(1) \
+    _DSP_FILTERS_FIR__TAPS2A(2) _DSP_FILTERS_FIR__TAPS2B(3) \
+    _DSP_FILTERS_FIR__TAPS2A(4) _DSP_FILTERS_FIR__TAPS2B(5) \
+    _DSP_FILTERS_FIR__TAPS2A(6) _DSP_FILTERS_FIR__TAPS2B_LAST(7)
+
+#define _DSP_FILTERS_FIR__TAPS8_LAST \
+    _DSP_FILTERS_FIR__TAPS2A(0) _DSP_FILTERS_FIR__TAPS2B(1) \
+    _DSP_FILTERS_FIR__TAPS2A(2) _DSP_FILTERS_FIR__TAPS2B_LAST(3)
+
+#define _DSP_FILTERS_FIR__DEFINE(N, TAPS) \
+int32_t dsp_filters_fir_##N \
+( \
+    int32_t        input_sample, \
+    const int32_t* filter_coeffs, \
+    int32_t*       state_data, \
+    const int32_t  q_format \
+) { \
+    int32_t ah = 0, b0, b1, s0 = input_sample, s1, s2, s3; \
+    uint32_t al = 1 << (q_format-1); \
+    TAPS \
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al)); \
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format)); \
+    return ah; \
+}
+
+_DSP_FILTERS_FIR__DEFINE( 16, _DSP_FILTERS_FIR__TAPS16_LAST )
+
+_DSP_FILTERS_FIR__DEFINE( 24, _DSP_FILTERS_FIR__TAPS16
+                              _DSP_FILTERS_FIR__TAPS8_LAST )
+
+_DSP_FILTERS_FIR__DEFINE( 32, _DSP_FILTERS_FIR__TAPS16
+                              _DSP_FILTERS_FIR__TAPS16_LAST )
+
+_DSP_FILTERS_FIR__DEFINE( 64, _DSP_FILTERS_FIR__TAPS16
+                              _DSP_FILTERS_FIR__TAPS16
+                              _DSP_FILTERS_FIR__TAPS16
+                              _DSP_FILTERS_FIR__TAPS16_LAST )
+
+_DSP_FILTERS_FIR__DEFINE( 128, _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16
+                               _DSP_FILTERS_FIR__TAPS16_LAST )
+
+
+
 // FIR filter push samples into an Finite Impulse Response (FIR) filter state array
 
 void dsp_filters_fir_add_sample
@@ -1168,6 +1253,7 @@ int32_t _dsp_filters_interpolate__fir_even
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s0),"0"(ah),"1"(al));
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s1),"0"(ah),"1"(al));
         asm("ldd %0,%1,%2[2]":"=r"(b1),"=r"(b0):"r"(coeff));
+        asm("ldd %0,%1,%2[2]":"=r"(s1),"=r"(s0):"r"(state));
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s0),"0"(ah),"1"(al));
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s1),"0"(ah),"1"(al));
         break;
@@ -1205,6 +1291,7 @@ int32_t _dsp_filters_interpolate__fir_even
 
         case 2:
         asm("ldd %0,%1,%2[0]":"=r"(b1),"=r"(b0):"r"(coeff));
+        asm("ldd %0,%1,%2[0]":"=r"(s1),"=r"(s0):"r"(state));
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b0),"r"(s0),"0"(ah),"1"(al));
         asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(b1),"r"(s1),"0"(ah),"1"(al));
         break;
@@ -1441,6 +1528,235 @@ void dsp_filters_interpolate
 
 
 
+void dsp_filters_interpolate_block
+(
+    const int32_t input_samples[],
+    const int32_t num_inputs,
+    const int32_t coeff[],
+    int32_t       state[],
+    const int32_t num_taps,
+    const int32_t interp_factor,
+    int32_t       output_samples[],
+    const int32_t q_format
+) {
+    int32_t length = num_taps / interp_factor;
+
+    for( int32_t n = 0; n < num_inputs; ++n )
+    {
+        const int32_t* cc = coeff;
+        dsp_filters_fir_add_sample( input_samples[n], state, length );
+        for( int32_t i = 0; i < interp_factor; ++i )
+        {
+            *output_samples++ = _dsp_filters_interpolate__fir_even( cc, state, length, q_format );
+            cc += length;
+        }
+    }
+}
+
+
+
+void dsp_filters_resampler_init
+(
+    dsp_filters_resampler_t* resampler,
+    const int32_t            filter_coeffs[],
+    int32_t                  state_data[],
+    const int32_t            num_taps,
+    const int32_t            interp_factor,
+    const int32_t            decim_factor,
+    const int32_t            q_format
+) {
+    resampler->filter_coeffs = filter_coeffs;
+    resampler->state_data    = state_data;
+    resampler->phase_length  = num_taps / interp_factor;
+    resampler->interp_factor = interp_factor;
+    resampler->decim_factor  = decim_factor;
+    resampler->phase         = 0;
+    resampler->q_format      = q_format;
+    for( int32_t i = 0; i < resampler->phase_length; ++i ) state_data[i] = 0;
+}
+
+
+
+int32_t dsp_filters_resampler_process
+(
+    dsp_filters_resampler_t* resampler,
+    const int32_t            input_samples[],
+    const int32_t            num_inputs,
+    int32_t                  output_samples[]
+) {
+    const int32_t* coeff  = resampler->filter_coeffs;
+    int32_t*       state  = resampler->state_data;
+    int32_t        length = resampler->phase_length;
+    int32_t        L      = resampler->interp_factor;
+    int32_t        M      = resampler->decim_factor;
+    int32_t        phase  = resampler->phase;
+    int32_t        count  = 0;
+
+    /*
+    L = 3, M = 2: outputs fall on every 2nd sample of the zero-stuffed stream
+
+    t          0  1  2  3  4  5  6  7  8
+    input     x0       x1       x2
+    output    y0    y1    y2    y3    y4
+    phase      0     2     1     0     2
+
+    Only the sub-filter for the phase of each output is evaluated.
+    */
+
+    for( int32_t n = 0; n < num_inputs; ++n )
+    {
+        dsp_filters_fir_add_sample( input_samples[n], state, length );
+        while( phase < L )
+        {
+            output_samples[count++] =
+                _dsp_filters_interpolate__fir_even( coeff + phase * length, state, length, resampler->q_format );
+            phase += M;
+        }
+        phase -= L;
+    }
+    resampler->phase = phase;
+    return count;
+}
+
+
+
+static int32_t _dsp_filters_asrc__tap( const int32_t* prototype, int32_t num_taps, int32_t index )
+{
+    return (index < 0 || index >= num_taps) ? 0 : prototype[index];
+}
+
+static int32_t _dsp_filters_asrc__div6( int64_t x )
+{
+    return (int32_t)((x + (x >= 0 ? 3 : -3)) / 6);
+}
+
+void dsp_filters_asrc_design
+(
+    const int32_t prototype[],
+    const int32_t num_taps,
+    const int32_t num_phases,
+    const int32_t poly_order,
+    int32_t       filter_coeffs[]
+) {
+    int32_t length = num_taps / num_phases;
+
+    for( int32_t p = 0; p < num_phases; ++p )
+    {
+        int32_t* cc = filter_coeffs + p * (poly_order + 1) * length;
+        for( int32_t k = 0; k < length; ++k )
+        {
+            int64_t ym1 = _dsp_filters_asrc__tap( prototype, num_taps, k * num_phases + p - 1 );
+            int64_t y0  = _dsp_filters_asrc__tap( prototype, num_taps, k * num_phases + p + 0 );
+            int64_t y1  = _dsp_filters_asrc__tap( prototype, num_taps, k * num_phases + p + 1 );
+            int64_t y2  = _dsp_filters_asrc__tap( prototype, num_taps, k * num_phases + p + 2 );
+
+            if( poly_order == 1 )
+            {
+                // Linear interpolation between phase p and phase p+1
+                cc[k]          = (int32_t) y0;
+                cc[k + length] = (int32_t)(y1 - y0);
+            }
+            else
+            {
+                // Cubic Lagrange interpolation through phases p-1, p, p+1 and p+2
+                cc[k]              = (int32_t) y0;
+                cc[k + length]     = _dsp_filters_asrc__div6( -2*ym1 - 3*y0 + 6*y1 - y2 );
+                cc[k + length * 2] = _dsp_filters_asrc__div6( 3*ym1 - 6*y0 + 3*y1 );
+                cc[k + length * 3] = _dsp_filters_asrc__div6( -ym1 + 3*y0 - 3*y1 + y2 );
+            }
+        }
+    }
+}
+
+
+
+int32_t dsp_filters_asrc_init
+(
+    dsp_filters_asrc_t* asrc,
+    const int32_t       filter_coeffs[],
+    int32_t             state_data[],
+    const int32_t       num_taps,
+    const int32_t       num_phases,
+    const int32_t       poly_order,
+    const int32_t       ratio,
+    const int32_t       q_format
+) {
+    asrc->filter_coeffs = filter_coeffs;
+    asrc->state_data    = state_data;
+    asrc->phase_length  = num_taps / num_phases;
+    asrc->num_phases    = num_phases;
+    asrc->poly_order    = poly_order;
+    asrc->ratio         = 1 << DSP_FILTERS_ASRC_RATIO_Q;
+    asrc->position      = 0;
+    asrc->q_format      = q_format;
+    for( int32_t i = 0; i < asrc->phase_length; ++i ) state_data[i] = 0;
+    return dsp_filters_asrc_set_ratio( asrc, ratio );
+}
+
+
+
+int32_t dsp_filters_asrc_set_ratio
+(
+    dsp_filters_asrc_t* asrc,
+    const int32_t       ratio
+) {
+    // A ratio of zero or less would never advance past the newest input sample,
+    // and the position plus the ratio must stay below 8 in Q28
+    if( ratio <= 0 || ratio >= (4 << DSP_FILTERS_ASRC_RATIO_Q) ) return -1;
+    asrc->ratio = ratio;
+    return 0;
+}
+
+
+
+int32_t dsp_filters_asrc_process
+(
+    dsp_filters_asrc_t* asrc,
+    const int32_t       input_samples[],
+    const int32_t       num_inputs,
+    int32_t             output_samples[]
+) {
+    const int32_t one    = 1 << DSP_FILTERS_ASRC_RATIO_Q;
+    int32_t*      state  = asrc->state_data;
+    int32_t       length = asrc->phase_length;
+    int32_t       order  = asrc->poly_order;
+    int32_t       format = asrc->q_format;
+    int32_t       pos    = asrc->position;
+    int32_t       count  = 0;
+
+    // pos is the time of the next output sample after the newest input sample,
+    // in input sample periods (Q28). Scaled by num_phases its integer part
+    // selects the sub-filter and its fractional part is the Farrow fraction mu.
+
+    for( int32_t n = 0; n < num_inputs; ++n )
+    {
+        dsp_filters_fir_add_sample( input_samples[n], state, length );
+        while( pos < one )
+        {
+            uint64_t       scaled = (uint64_t) pos * asrc->num_phases;
+            int32_t        phase  = (int32_t)(scaled >> DSP_FILTERS_ASRC_RATIO_Q);
+            int32_t        mu     = (int32_t)((scaled & (one - 1)) << (31 - DSP_FILTERS_ASRC_RATIO_Q));
+            const int32_t* cc     = asrc->filter_coeffs + phase * (order + 1) * length;
+            int32_t        result;
+
+            // Horner's rule: y = ((c3*mu + c2)*mu + c1)*mu + c0
+            result = _dsp_filters_interpolate__fir_even( cc + order * length, state, length, format );
+            for( int32_t d = order - 1; d >= 0; --d )
+            {
+                result = dsp_math_multiply( result, mu, 31 )
+                       + _dsp_filters_interpolate__fir_even( cc + d * length, state, length, format );
+            }
+            output_samples[count++] = result;
+            pos += asrc->ratio;
+        }
+        pos -= one;
+    }
+    asrc->position = pos;
+    return count;
+}
+
+
+
 int32_t dsp_filters_decimate
 (
     int32_t       input_samples[],
@@ -1469,6 +1785,127 @@ int32_t dsp_filters_decimate
 
 
 
+// Packed 16-bit coefficients are used in the upper half of each 32-bit MAC
+// operand (c<<16 for the even tap, c&0xFFFF0000 for the odd tap), which
+// scales every product by 2^16; the final extraction shifts by q_format+16.
+
+int32_t dsp_filters_fir_c16
+(
+    int32_t        input_sample,
+    const int16_t* filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_taps,
+    const int32_t  q_format
+) {
+    int32_t ah = 0, c10, c32, s0 = input_sample, s1, s2, s3;
+    uint32_t al = 1 << (q_format+15);
+    const int32_t* cc = (const int32_t*) filter_coeffs;
+    int32_t nt = num_taps;
+
+    while( nt > 4 )
+    {
+        asm("ldd %0,%1,%2[0]":"=r"(c32),"=r"(c10):"r"(cc));
+        asm("ldd %0,%1,%2[0]":"=r"(s2),"=r"(s1):"r"(state_data));
+        asm("std %0,%1,%2[0]"::"r"(s1), "r"(s0),"r"(state_data));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c10<<16),"r"(s0),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c10&0xFFFF0000),"r"(s1),"0"(ah),"1"(al));
+
+        asm("ldd %0,%1,%2[1]":"=r"(s0),"=r"(s3):"r"(state_data));
+        asm("std %0,%1,%2[1]"::"r"(s3), "r"(s2),"r"(state_data));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c32<<16),"r"(s2),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c32&0xFFFF0000),"r"(s3),"0"(ah),"1"(al));
+
+        nt -= 4; cc += 2; state_data += 4;
+    }
+
+    // Remaining one to four taps, touching only the N-1 valid state words
+    filter_coeffs = (const int16_t*) cc;
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(filter_coeffs[0]<<16),"r"(s0),"0"(ah),"1"(al));
+    for( int32_t i = 1; i < nt; ++i )
+    {
+        s1 = state_data[i-1];
+        state_data[i-1] = s0;
+        s0 = s1;
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(filter_coeffs[i]<<16),"r"(s0),"0"(ah),"1"(al));
+    }
+
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format+16),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format+16));
+    return ah;
+}
+
+// FIR filter with packed 16-bit coefficients (even tap count, no state data
+// shifting - for internal use only)
+
+static int32_t _dsp_filters_fir__c16_even
+(
+    const int16_t* coeff,
+    const int32_t* state,
+    int32_t        taps,
+    int32_t        format
+) {
+    int32_t ah = 0, c, s0, s1;
+    uint32_t al = 1 << (format+15);
+    const int32_t* cc = (const int32_t*) coeff;
+
+    while( taps >= 2 )
+    {
+        c = *cc++;
+        asm("ldd %0,%1,%2[0]":"=r"(s1),"=r"(s0):"r"(state));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c<<16),"r"(s0),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(c&0xFFFF0000),"r"(s1),"0"(ah),"1"(al));
+        taps -= 2; state += 2;
+    }
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(format+16),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(format+16));
+    return ah;
+}
+
+
+
+void dsp_filters_interpolate_c16
+(
+    int32_t       input,
+    const int16_t coeff[],
+    int32_t       state[],
+    const int32_t num_taps,
+    const int32_t interp_factor,
+    int32_t       output_samples[],
+    const int32_t q_format
+) {
+    int32_t length = num_taps / interp_factor;
+
+    dsp_filters_fir_add_sample( input, state, length );
+    for( int32_t i = 0; i < interp_factor; ++i )
+    {
+        output_samples[i] = _dsp_filters_fir__c16_even( coeff, state, length, q_format );
+        coeff += length;
+    }
+}
+
+
+
+int32_t dsp_filters_decimate_c16
+(
+    int32_t       input_samples[],
+    const int16_t filter_coeffs[],
+    int32_t       state_data[],
+    const int32_t num_taps,
+    const int32_t decim_factor,
+    const int32_t q_format
+) {
+    int32_t  output;
+    int32_t* dst = state_data + num_taps - 2;
+    int32_t* src = dst - (decim_factor-1);
+
+    output = dsp_filters_fir_c16( input_samples[0], filter_coeffs, state_data, num_taps, q_format );
+    for( int32_t i = 0; i < num_taps - decim_factor; ++i ) *dst-- = *src--;
+    for( int32_t i = 0; i < decim_factor-1; ++i ) state_data[i] = input_samples[i+1];
+    return output;
+}
+
+
+
 int32_t dsp_filters_biquad
 (
     int32_t        input_sample,
@@ -1727,3 +2164,713 @@ int32_t dsp_filters_biquads
     }
     return 0;
 }
+
+
+int32_t dsp_filters_biquad_ef
+(
+    int32_t        input_sample,
+    const int32_t* filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  q_format
+) {
+    uint32_t al; int32_t ah, s1,s2;
+
+    // Accumulator is pre-loaded with the fraction discarded on the previous sample
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(input_sample),"r"(filter_coeffs[0]),"0"(0),"1"(state_data[4]));
+    asm("ldd %0,%1,%2[0]":"=r"(s2),"=r"(s1):"r"(state_data));
+    asm("std %0,%1,%2[0]"::"r"(s1),"r"(input_sample),"r"(state_data));
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(s1),"r"(filter_coeffs[1]),"0"(ah),"1"(al));
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(s2),"r"(filter_coeffs[2]),"0"(ah),"1"(al));
+    asm("ldd %0,%1,%2[1]":"=r"(s2),"=r"(s1):"r"(state_data));
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(s1),"r"(filter_coeffs[3]),"0"(ah),"1"(al));
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(s2),"r"(filter_coeffs[4]),"0"(ah),"1"(al));
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    state_data[4] = al & ((1u << q_format) - 1);
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+    asm("std %0,%1,%2[1]"::"r"(s1),"r"(ah),"r"(state_data));
+    return ah;
+}
+
+
+
+int32_t dsp_filters_biquads_ef
+(
+    int32_t        input_sample,
+    const int32_t* filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_sections,
+    const int32_t  q_format
+) {
+    for( int32_t s = 0; s < num_sections; ++s )
+    {
+        input_sample = dsp_filters_biquad_ef( input_sample, filter_coeffs, state_data, q_format );
+        filter_coeffs += DSP_NUM_COEFFS_PER_BIQUAD;
+        state_data    += DSP_NUM_STATES_PER_BIQUAD_EF;
+    }
+    return input_sample;
+}
+
+
+// Biquad section over a block of samples (for internal use only)
+// Coefficients and the x[n-1],x[n-2],y[n-1],y[n-2] history are read once
+// into locals for the whole block and the history is written back at the end.
+
+static void _dsp_filters_biquad__block
+(
+    const int32_t* input,
+    int32_t*       output,
+    const int32_t  stride,
+    const int32_t  count,
+    const int32_t* coeffs,
+    int32_t*       x_state,
+    int32_t*       y_state,
+    const int32_t  q_format
+) {
+    uint32_t al; int32_t ah, x;
+    int32_t b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2], a1 = coeffs[3], a2 = coeffs[4];
+    int32_t x1 = x_state[0], x2 = x_state[1], y1 = y_state[0], y2 = y_state[1];
+
+    for( int32_t i = 0; i < count; ++i )
+    {
+        x = *input; input += stride;
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(x),"r"(b0),"0"(0),"1"(1<<(q_format-1)));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(x1),"r"(b1),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(x2),"r"(b2),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(y1),"r"(a1),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(y2),"r"(a2),"0"(ah),"1"(al));
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        x2 = x1; x1 = x; y2 = y1; y1 = ah;
+        *output = ah; output += stride;
+    }
+    x_state[0] = x1; x_state[1] = x2;
+    y_state[0] = y1; y_state[1] = y2;
+}
+
+
+
+void dsp_filters_biquads_multichannel
+(
+    int32_t        samples[],
+    const int32_t  num_channels,
+    const int32_t  frame_length,
+    const int32_t  interleaved,
+    const int32_t* filter_coeffs,
+    const int32_t  per_channel_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_sections,
+    const int32_t  q_format
+) {
+    int32_t stride = interleaved ? num_channels : 1;
+
+    for( int32_t s = 0; s < num_sections; ++s )
+    {
+        const int32_t* cc = filter_coeffs + s * DSP_NUM_COEFFS_PER_BIQUAD;
+        for( int32_t ch = 0; ch < num_channels; ++ch )
+        {
+            int32_t* data = samples + (interleaved ? ch : ch * frame_length);
+            if( per_channel_coeffs )
+                cc = filter_coeffs + (ch * num_sections + s) * DSP_NUM_COEFFS_PER_BIQUAD;
+            _dsp_filters_biquad__block( data, data, stride, frame_length, cc, state_data, state_data + 2, q_format );
+            state_data += DSP_NUM_STATES_PER_BIQUAD;
+        }
+    }
+}
+
+
+
+void dsp_filters_biquads_block
+(
+    const int32_t  input_samples[],
+    int32_t        output_samples[],
+    const int32_t  frame_length,
+    const int32_t* filter_coeffs,
+    int32_t*       state_data,
+    const int32_t  num_sections,
+    const int32_t  q_format
+) {
+    const int32_t* input = input_samples;
+
+    for( int32_t s = 0; s < num_sections; ++s )
+    {
+        _dsp_filters_biquad__block( input, output_samples, 1, frame_length,
+                                    filter_coeffs, state_data, state_data + 2, q_format );
+        filter_coeffs += DSP_NUM_COEFFS_PER_BIQUAD;
+        state_data    += DSP_NUM_STATES_PER_BIQUAD;
+        input = output_samples;
+    }
+}
+
+
+
+void dsp_filters_biquad_smooth_init
+(
+    dsp_filters_biquad_smooth_t* filter,
+    const int32_t                filter_coeffs[],
+    const int32_t                shift,
+    const int32_t                q_format
+) {
+    for( int32_t i = 0; i < DSP_NUM_COEFFS_PER_BIQUAD; ++i )
+        filter->coeffs[i] = filter->target[i] = filter_coeffs[i];
+    for( int32_t i = 0; i < DSP_NUM_STATES_PER_BIQUAD; ++i )
+        filter->state[i] = 0;
+    filter->shift    = shift;
+    filter->q_format = q_format;
+}
+
+
+
+void dsp_filters_biquad_smooth_set_target
+(
+    dsp_filters_biquad_smooth_t* filter,
+    const int32_t                filter_coeffs[]
+) {
+    for( int32_t i = 0; i < DSP_NUM_COEFFS_PER_BIQUAD; ++i )
+        filter->target[i] = filter_coeffs[i];
+}
+
+
+
+void dsp_filters_biquad_smooth_process
+(
+    dsp_filters_biquad_smooth_t* filter,
+    const int32_t                input_samples[],
+    int32_t                      output_samples[],
+    const int32_t                frame_length,
+    const int32_t                update_interval
+) {
+    int32_t shift    = filter->shift;
+    int32_t interval = update_interval < 1 ? 1 : update_interval;
+
+    for( int32_t i = 0; i < frame_length; i += interval )
+    {
+        int32_t count = frame_length - i < interval ? frame_length - i : interval;
+
+        // c += (target - c) / 2^shift, truncated per coefficient, so [-a1,-a2]
+        // stays within about 2^shift LSBs of the line between the current and
+        // target pairs. The difference needs 33 bits; the new coefficient lies
+        // between c and target so fits 32.
+        for( int32_t k = 0; k < DSP_NUM_COEFFS_PER_BIQUAD; ++k )
+        {
+            int64_t step = ((int64_t) filter->target[k] - filter->coeffs[k]) >> shift;
+            filter->coeffs[k] = step ? (int32_t)(filter->coeffs[k] + step) : filter->target[k];
+        }
+        _dsp_filters_biquad__block( input_samples + i, output_samples + i, 1, count,
+                                    filter->coeffs, filter->state, filter->state + 2,
+                                    filter->q_format );
+    }
+}
+
+
+
+void dsp_filters_cic_init
+(
+    dsp_filters_cic_t* cic,
+    const int32_t      order,
+    const int32_t      decim_factor
+) {
+    uint64_t gain   = 1;
+    int32_t  growth = 0;
+
+    for( int32_t i = 0; i < DSP_FILTERS_CIC_MAX_ORDER; ++i )
+        cic->integrators[i] = cic->combs[i] = 0;
+    cic->order        = order;
+    cic->decim_factor = decim_factor;
+    cic->count        = 0;
+
+    // Shift = ceil( order * log2(decim_factor) ), the smallest s with
+    // R^N <= 2^s. The output only fits in 32 bits if R^N does.
+    for( int32_t k = 0; k < order; ++k ) gain *= decim_factor;
+    while( growth < 31 && ((uint64_t) 1 << growth) < gain ) ++growth;
+    cic->shift = growth;
+}
+
+
+
+int32_t dsp_filters_cic_decimate
+(
+    dsp_filters_cic_t* cic,
+    const int32_t      input_samples[],
+    const int32_t      num_inputs,
+    int32_t            output_samples[]
+) {
+    // Integrators and combs use modulo 2^32 arithmetic: intermediate
+    // integrator overflow cancels in the combs as long as the final output
+    // fits in 32 bits.
+    uint32_t* ii    = (uint32_t*) cic->integrators;
+    uint32_t* cc    = (uint32_t*) cic->combs;
+    int32_t   order = cic->order;
+    int32_t   count = cic->count;
+    int32_t   num_outputs = 0;
+
+    for( int32_t n = 0; n < num_inputs; ++n )
+    {
+        uint32_t acc = (uint32_t) input_samples[n];
+        for( int32_t k = 0; k < order; ++k )
+        {
+            ii[k] += acc;
+            acc = ii[k];
+        }
+        if( ++count == cic->decim_factor )
+        {
+            count = 0;
+            for( int32_t k = 0; k < order; ++k )
+            {
+                uint32_t delayed = cc[k];
+                cc[k] = acc;
+                acc -= delayed;
+            }
+            output_samples[num_outputs++] = (int32_t) acc >> cic->shift;
+        }
+    }
+    cic->count = count;
+    return num_outputs;
+}
+
+
+
+// Lattice stage arithmetic: returns sat( acc + k*x ) in the format of acc,
+// with k in Q(q) and the product rounded, using one maccs.
+
+static inline int32_t _dsp_filters_lattice__mac( int32_t acc, int32_t k, int32_t x, int32_t q )
+{
+    int32_t ah = acc >> (32-q);
+    uint32_t al = ((uint32_t) acc << q) | (1 << (q-1));
+
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(k),"r"(x),"0"(ah),"1"(al));
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q));
+    return ah;
+}
+
+// All-pole lattice, stages processed from the top down. The backward output
+// of the top stage is written to *top; the others update state in place.
+// The forward update negates k, which is why k = INT32_MIN is not supported.
+
+static int32_t _dsp_filters_lattice__allpole
+(
+    int32_t        input,
+    const int32_t* k,
+    int32_t*       state,
+    int32_t        order,
+    int32_t        q,
+    int32_t*       top
+) {
+    int32_t f = input, g0, g1, k0, k1;
+    int32_t* dst = top;
+    int32_t m = order;
+
+    if( m & 1 )
+    {
+        --m;
+        g0 = state[m];
+        f = _dsp_filters_lattice__mac( f, -k[m], g0, q );
+        *dst = _dsp_filters_lattice__mac( g0, k[m], f, q );
+        dst = state + m;
+    }
+    while( m >= 2 )
+    {
+        m -= 2;
+        asm("ldd %0,%1,%2[0]":"=r"(k1),"=r"(k0):"r"(k+m));
+        asm("ldd %0,%1,%2[0]":"=r"(g1),"=r"(g0):"r"(state+m));
+        f = _dsp_filters_lattice__mac( f, -k1, g1, q );
+        *dst = _dsp_filters_lattice__mac( g1, k1, f, q );
+        f = _dsp_filters_lattice__mac( f, -k0, g0, q );
+        state[m+1] = _dsp_filters_lattice__mac( g0, k0, f, q );
+        dst = state + m;
+    }
+    *dst = f;
+    return f;
+}
+
+
+
+int32_t dsp_filters_lattice_allzero
+(
+    int32_t        input_sample,
+    const int32_t* reflection_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    int32_t f = input_sample, g = input_sample, f1, g0, g1, k0, k1;
+    int32_t m = order;
+
+    while( m >= 2 )
+    {
+        asm("ldd %0,%1,%2[0]":"=r"(k1),"=r"(k0):"r"(reflection_coeffs));
+        asm("ldd %0,%1,%2[0]":"=r"(g1),"=r"(g0):"r"(state_data));
+        f1 = _dsp_filters_lattice__mac( f, k0, g0, q_format );
+        g0 = _dsp_filters_lattice__mac( g0, k0, f, q_format );
+        asm("std %0,%1,%2[0]"::"r"(g0), "r"(g),"r"(state_data));
+        f  = _dsp_filters_lattice__mac( f1, k1, g1, q_format );
+        g  = _dsp_filters_lattice__mac( g1, k1, f1, q_format );
+        m -= 2; reflection_coeffs += 2; state_data += 2;
+    }
+    if( m )
+    {
+        g0 = state_data[0];
+        state_data[0] = g;
+        f = _dsp_filters_lattice__mac( f, reflection_coeffs[0], g0, q_format );
+    }
+    return f;
+}
+
+
+
+int32_t dsp_filters_lattice_allpole
+(
+    int32_t        input_sample,
+    const int32_t* reflection_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    int32_t top;
+    return _dsp_filters_lattice__allpole( input_sample, reflection_coeffs, state_data, order, q_format, &top );
+}
+
+
+
+int32_t dsp_filters_lattice_ladder
+(
+    int32_t        input_sample,
+    const int32_t* reflection_coeffs,
+    const int32_t* ladder_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    int32_t ah = 0, v0, v1, g0, g1, top;
+    uint32_t al = 1 << (q_format-1);
+    int32_t m = order;
+
+    _dsp_filters_lattice__allpole( input_sample, reflection_coeffs, state_data, order, q_format, &top );
+
+    while( m >= 2 )
+    {
+        asm("ldd %0,%1,%2[0]":"=r"(v1),"=r"(v0):"r"(ladder_coeffs));
+        asm("ldd %0,%1,%2[0]":"=r"(g1),"=r"(g0):"r"(state_data));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(v0),"r"(g0),"0"(ah),"1"(al));
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(v1),"r"(g1),"0"(ah),"1"(al));
+        m -= 2; ladder_coeffs += 2; state_data += 2;
+    }
+    if( m )
+    {
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(ladder_coeffs[0]),"r"(state_data[0]),"0"(ah),"1"(al));
+        ++ladder_coeffs;
+    }
+    asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(ladder_coeffs[0]),"r"(top),"0"(ah),"1"(al));
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+    return ah;
+}
+
+
+
+void dsp_filters_lattice_allzero_block
+(
+    const int32_t  input_samples[],
+    int32_t        output_samples[],
+    const int32_t  frame_length,
+    const int32_t* reflection_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    for( int32_t n = 0; n < frame_length; ++n )
+        output_samples[n] = dsp_filters_lattice_allzero( input_samples[n], reflection_coeffs,
+                                                         state_data, order, q_format );
+}
+
+
+
+void dsp_filters_lattice_allpole_block
+(
+    const int32_t  input_samples[],
+    int32_t        output_samples[],
+    const int32_t  frame_length,
+    const int32_t* reflection_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    int32_t top;
+    for( int32_t n = 0; n < frame_length; ++n )
+        output_samples[n] = _dsp_filters_lattice__allpole( input_samples[n], reflection_coeffs,
+                                                           state_data, order, q_format, &top );
+}
+
+
+
+void dsp_filters_lattice_ladder_block
+(
+    const int32_t  input_samples[],
+    int32_t        output_samples[],
+    const int32_t  frame_length,
+    const int32_t* reflection_coeffs,
+    const int32_t* ladder_coeffs,
+    int32_t*       state_data,
+    const int32_t  order,
+    const int32_t  q_format
+) {
+    for( int32_t n = 0; n < frame_length; ++n )
+        output_samples[n] = dsp_filters_lattice_ladder( input_samples[n], reflection_coeffs,
+                                                        ladder_coeffs, state_data, order, q_format );
+}
+
+
+
+void dsp_filters_moving_average_init
+(
+    dsp_filters_moving_average_t* filter,
+    int32_t                       buffer[],
+    const int32_t                 length
+) {
+    filter->buffer = buffer;
+    filter->length = length;
+    filter->index  = 0;
+    filter->sum    = 0;
+    filter->shift  = -1;
+    for( int32_t i = 0; i < length; ++i ) buffer[i] = 0;
+    for( int32_t i = 0; i < 31; ++i ) if( length == (1 << i) ) filter->shift = i;
+}
+
+
+
+int32_t dsp_filters_moving_average
+(
+    dsp_filters_moving_average_t* filter,
+    int32_t                       input_sample
+) {
+    int32_t index = filter->index;
+    int64_t sum = filter->sum + input_sample - filter->buffer[index];
+    int32_t half;
+
+    filter->buffer[index] = input_sample;
+    filter->index = (index + 1 == filter->length) ? 0 : index + 1;
+    filter->sum = sum;
+
+    // Rounded mean: a shift for power-of-two windows, otherwise a division
+    if( filter->shift >= 0 )
+        return (int32_t)((sum + ((1 << filter->shift) >> 1)) >> filter->shift);
+    half = filter->length >> 1;
+    return (int32_t)(((sum < 0) ? sum - half : sum + half) / filter->length);
+}
+
+
+
+void dsp_filters_moving_average_block
+(
+    dsp_filters_moving_average_t* filter,
+    const int32_t                 input_samples[],
+    int32_t                       output_samples[],
+    const int32_t                 frame_length
+) {
+    for( int32_t n = 0; n < frame_length; ++n )
+        output_samples[n] = dsp_filters_moving_average( filter, input_samples[n] );
+}
+
+
+
+// Running median: heap[0..lower-1] is a max-heap of the lower half of the
+// window and heap[lower..length-1] a min-heap of the upper half. Heap entries
+// are window slot indices, and position[] maps each slot back to its heap
+// entry so the oldest sample can be replaced in place.
+
+static inline int32_t _dsp_filters_median__before( dsp_filters_median_t* m, int32_t a, int32_t b, int32_t is_max )
+{
+    int32_t va = m->data[m->heap[a]], vb = m->data[m->heap[b]];
+    return is_max ? (va > vb) : (va < vb);
+}
+
+static inline void _dsp_filters_median__swap( dsp_filters_median_t* m, int32_t a, int32_t b )
+{
+    int32_t ha = m->heap[a], hb = m->heap[b];
+    m->heap[a] = hb; m->position[hb] = a;
+    m->heap[b] = ha; m->position[ha] = b;
+}
+
+static void _dsp_filters_median__sift( dsp_filters_median_t* m, int32_t base, int32_t size, int32_t i, int32_t is_max )
+{
+    int32_t c;
+
+    while( i > 0 && _dsp_filters_median__before( m, base + i, base + (i-1)/2, is_max ) )
+    {
+        _dsp_filters_median__swap( m, base + i, base + (i-1)/2 );
+        i = (i-1)/2;
+    }
+    while( (c = 2*i + 1) < size )
+    {
+        if( c + 1 < size && _dsp_filters_median__before( m, base + c + 1, base + c, is_max ) ) ++c;
+        if( !_dsp_filters_median__before( m, base + c, base + i, is_max ) ) break;
+        _dsp_filters_median__swap( m, base + c, base + i );
+        i = c;
+    }
+}
+
+
+
+void dsp_filters_median_init
+(
+    dsp_filters_median_t* filter,
+    int32_t               buffer[],
+    const int32_t         length
+) {
+    filter->data     = buffer;
+    filter->heap     = buffer + length;
+    filter->position = buffer + 2 * length;
+    filter->length   = length;
+    filter->lower    = (length + 1) / 2;
+    filter->index    = 0;
+    for( int32_t i = 0; i < length; ++i )
+    {
+        filter->data[i] = 0;
+        filter->heap[i] = filter->position[i] = i;
+    }
+}
+
+
+
+int32_t dsp_filters_median
+(
+    dsp_filters_median_t* filter,
+    int32_t               input_sample
+) {
+    int32_t slot  = filter->index;
+    int32_t lower = filter->lower, upper = filter->length - lower;
+    int32_t p     = filter->position[slot];
+    int32_t a, b;
+
+    filter->data[slot] = input_sample;
+    filter->index = (slot + 1 == filter->length) ? 0 : slot + 1;
+
+    // Restore the heap holding the replaced sample, then the ordering between halves
+    if( p < lower ) _dsp_filters_median__sift( filter, 0, lower, p, 1 );
+    else            _dsp_filters_median__sift( filter, lower, upper, p - lower, 0 );
+    if( upper > 0 && filter->data[filter->heap[0]] > filter->data[filter->heap[lower]] )
+    {
+        _dsp_filters_median__swap( filter, 0, lower );
+        _dsp_filters_median__sift( filter, 0, lower, 0, 1 );
+        _dsp_filters_median__sift( filter, lower, upper, 0, 0 );
+    }
+
+    a = filter->data[filter->heap[0]];
+    if( lower > upper ) return a;
+    b = filter->data[filter->heap[lower]];
+    return (int32_t)(((int64_t) a + b) >> 1);
+}
+
+
+
+void dsp_filters_median_block
+(
+    dsp_filters_median_t* filter,
+    const int32_t         input_samples[],
+    int32_t               output_samples[],
+    const int32_t         frame_length
+) {
+    for( int32_t n = 0; n < frame_length; ++n )
+        output_samples[n] = dsp_filters_median( filter, input_samples[n] );
+}
+
+
+
+int32_t dsp_filters_sparse_fir_from_dense
+(
+    const int32_t dense_coeffs[],
+    const int32_t num_dense,
+    const int32_t threshold,
+    uint32_t      delays[],
+    int32_t       coeffs[],
+    const int32_t max_taps
+) {
+    int32_t count = 0;
+
+    for( int32_t i = 0; i < num_dense; ++i )
+    {
+        int32_t c = dense_coeffs[i];
+        if( c > threshold || c < -threshold )
+        {
+            if( count < max_taps )
+            {
+                delays[count] = i;
+                coeffs[count] = c;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+
+
+void dsp_filters_sparse_fir_init
+(
+    dsp_filters_sparse_fir_t* filter,
+    const uint32_t            delays[],
+    const int32_t             coeffs[],
+    const int32_t             num_taps,
+    int32_t                   history[],
+    const int32_t             history_length,
+    const int32_t             q_format
+) {
+    filter->history  = history;
+    filter->delays   = delays;
+    filter->coeffs   = coeffs;
+    filter->num_taps = num_taps;
+    filter->mask     = history_length - 1;
+    filter->index    = 0;
+    filter->q_format = q_format;
+    for( int32_t i = 0; i < history_length; ++i ) history[i] = 0;
+}
+
+
+
+int32_t dsp_filters_sparse_fir
+(
+    dsp_filters_sparse_fir_t* filter,
+    int32_t                   input_sample
+) {
+    int32_t output;
+
+    dsp_filters_sparse_fir_block( filter, &input_sample, &output, 1 );
+    return output;
+}
+
+
+
+void dsp_filters_sparse_fir_block
+(
+    dsp_filters_sparse_fir_t* filter,
+    const int32_t             input_samples[],
+    int32_t                   output_samples[],
+    const int32_t             frame_length
+) {
+    int32_t*        history  = filter->history;
+    const uint32_t* delays   = filter->delays;
+    const int32_t*  coeffs   = filter->coeffs;
+    int32_t         num_taps = filter->num_taps;
+    uint32_t        mask     = filter->mask;
+    uint32_t        index    = filter->index;
+    int32_t         q_format = filter->q_format;
+
+    for( int32_t n = 0; n < frame_length; ++n )
+    {
+        int32_t  ah = 0;
+        uint32_t al = 1 << (q_format-1);
+
+        index = (index + 1) & mask;
+        history[index] = input_samples[n];
+
+        // Only the stored taps are visited; each reads its sample at a masked offset
+        for( int32_t t = 0; t < num_taps; ++t )
+        {
+            asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(coeffs[t]),"r"(history[(index - delays[t]) & mask]),"0"(ah),"1"(al));
+        }
+        asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+        asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+        output_samples[n] = ah;
+    }
+    filter->index = index;
+}
@@ -0,0 +1,189 @@
+// Copyright (c) 2018, XMOS Ltd, All rights reserved
+
+#include <platform.h>
+#include "dsp_kalman.h"
+
+
+
+void dsp_kalman_init
+(
+    dsp_kalman_t* kf,
+    const int32_t num_states,
+    const int32_t num_measurements,
+    int32_t       state[],
+    int32_t       covariance[],
+    const int32_t transition[],
+    const int32_t process_noise[],
+    const int32_t observation[],
+    const int32_t measurement_noise[],
+    int32_t       scratch[],
+    const int32_t q_format
+) {
+    kf->state             = state;
+    kf->covariance        = covariance;
+    kf->transition        = transition;
+    kf->process_noise     = process_noise;
+    kf->observation       = observation;
+    kf->measurement_noise = measurement_noise;
+    kf->scratch           = scratch;
+    kf->num_states        = num_states;
+    kf->num_measurements  = num_measurements;
+    kf->q_format          = q_format;
+}
+
+
+
+// Rounded and saturated (bias + a . b) in q_format, with bias in q_format and a
+// single 64-bit accumulation.
+
+static int32_t _dsp_kalman__dot
+(
+    const int32_t* a,
+    const int32_t* b,
+    const int32_t  n,
+    const int32_t  bias,
+    const int32_t  q_format
+) {
+    int64_t  acc = ((int64_t) bias << q_format) + (1 << (q_format-1));
+    int32_t  ah = (int32_t)(acc >> 32);
+    uint32_t al = (uint32_t) acc;
+
+    for( int32_t k = 0; k < n; ++k )
+    {
+        asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(a[k]),"r"(b[k]),"0"(ah),"1"(al));
+    }
+    asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q_format),"0"(ah),"1"(al));
+    asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q_format));
+    return ah;
+}
+
+static void _dsp_kalman__predict( dsp_kalman_t* kf )
+{
+    const int32_t* F = kf->transition;
+    const int32_t* Q = kf->process_noise;
+    int32_t*       P = kf->covariance;
+    int32_t*       T = kf->scratch;
+    int32_t        n = kf->num_states;
+    int32_t        q = kf->q_format;
+    int32_t        x[DSP_KALMAN_MAX_STATES];
+
+    for( int32_t i = 0; i < n; ++i ) x[i] = _dsp_kalman__dot( F + i*n, kf->state, n, 0, q );
+    for( int32_t i = 0; i < n; ++i ) kf->state[i] = x[i];
+
+    // T = F * P, reading column j of the symmetric P as row j
+    for( int32_t i = 0; i < n; ++i )
+        for( int32_t j = 0; j < n; ++j )
+            T[i*n + j] = _dsp_kalman__dot( F + i*n, P + j*n, n, 0, q );
+
+    // P = T * F' + Q, upper triangle mirrored
+    for( int32_t i = 0; i < n; ++i )
+        for( int32_t j = i; j < n; ++j )
+            P[i*n + j] = P[j*n + i] = _dsp_kalman__dot( T + i*n, F + j*n, n, Q[i*n + j], q );
+}
+
+// k = u / s in q_format, from one reciprocal of s.
+
+static void _dsp_kalman__gain
+(
+    const int32_t* u,
+    int32_t        s,
+    int32_t*       k,
+    const int32_t  n,
+    const int32_t  q_format
+) {
+    uint32_t r;
+    int32_t  z, shift;
+    int64_t  g;
+
+    // 1/s = r * 2^(z-61), with s normalised to [2^30, 2^31) and r = 2^61 / s
+    asm("clz %0,%1":"=r"(z):"r"(s));
+    z -= 1;
+    r = (uint32_t)((1ULL << 61) / (uint32_t)(s << z));
+    shift = 61 - z - q_format;
+
+    for( int32_t i = 0; i < n; ++i )
+    {
+        g = ((int64_t) u[i] * r + (1LL << (shift-1))) >> shift;
+        k[i] = (g > 0x7FFFFFFF) ? 0x7FFFFFFF : (g < -0x7FFFFFFF) ? -0x7FFFFFFF : (int32_t) g;
+    }
+}
+
+static void _dsp_kalman__update( dsp_kalman_t* kf, const int32_t measurements[] )
+{
+    int32_t* P = kf->covariance;
+    int32_t* x = kf->state;
+    int32_t  n = kf->num_states;
+    int32_t  q = kf->q_format;
+    int32_t  u[DSP_KALMAN_MAX_STATES], k[DSP_KALMAN_MAX_STATES], w[DSP_KALMAN_MAX_STATES];
+    int32_t  s, innovation, ah;
+    uint32_t al;
+
+    for( int32_t m = 0; m < kf->num_measurements; ++m )
+    {
+        const int32_t* h = kf->observation + m*n;
+
+        // u = P * h', s = h * u + r
+        for( int32_t i = 0; i < n; ++i ) u[i] = _dsp_kalman__dot( P + i*n, h, n, 0, q );
+        s = _dsp_kalman__dot( h, u, n, kf->measurement_noise[m], q );
+        if( s <= 0 ) continue;
+        _dsp_kalman__gain( u, s, k, n, q );
+
+        // x = x + k * (z - h * x)
+        innovation = measurements[m] - _dsp_kalman__dot( h, x, n, 0, q );
+        for( int32_t i = 0; i < n; ++i ) x[i] = _dsp_kalman__dot( k + i, &innovation, 1, x[i], q );
+
+        // Joseph form P - k * u' - u * k' + (s * k) * k', one rounding per element
+        for( int32_t i = 0; i < n; ++i ) w[i] = _dsp_kalman__dot( &s, k + i, 1, 0, q );
+        for( int32_t i = 0; i < n; ++i )
+        {
+            int32_t nk = -k[i], nu = -u[i];
+            for( int32_t j = i; j < n; ++j )
+            {
+                int64_t acc = ((int64_t) P[i*n + j] << q) + (1 << (q-1));
+                ah = (int32_t)(acc >> 32);
+                al = (uint32_t) acc;
+                asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(nk),"r"(u[j]),"0"(ah),"1"(al));
+                asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(nu),"r"(k[j]),"0"(ah),"1"(al));
+                asm("maccs %0,%1,%2,%3":"=r"(ah),"=r"(al):"r"(w[i]),"r"(k[j]),"0"(ah),"1"(al));
+                asm("lsats %0,%1,%2":"=r"(ah),"=r"(al):"r"(q),"0"(ah),"1"(al));
+                asm("lextract %0,%1,%2,%3,32":"=r"(ah):"r"(ah),"r"(al),"r"(q));
+                P[i*n + j] = P[j*n + i] = ah;
+            }
+        }
+    }
+}
+
+
+
+void dsp_kalman_predict
+(
+    dsp_kalman_t* kf
+) {
+    _dsp_kalman__predict( kf );
+}
+
+
+
+void dsp_kalman_update
+(
+    dsp_kalman_t* kf,
+    const int32_t measurements[]
+) {
+    _dsp_kalman__update( kf, measurements );
+}
+
+
+
+void dsp_kalman_step_batch
+(
+    dsp_kalman_t  kf[],
+    const int32_t measurements[],
+    const int32_t num_filters
+) {
+    for( int32_t f = 0; f < num_filters; ++f )
+    {
+        _dsp_kalman__predict( &kf[f] );
+        _dsp_kalman__update( &kf[f], measurements );
+        measurements += kf[f].num_measurements;
+    }
+}